@@ -0,0 +1,434 @@
+#include "cluestore.h"
+
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <string.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QString>
+
+static const char clueMagic[8] = { 'R', 'E', 'C', 'L', 'U', 'E', 'S', 0 };
+static const quint32 byteOrderMark = 0x01020304;
+
+// answers per hash bucket, on average
+static const int bucketSize = 3;
+static const quint32 maxSeed = 1 << 24;
+
+ClueStore::ClueStore()
+{
+}
+
+ClueStore::~ClueStore()
+{
+    delete m_file;
+}
+
+quint64 ClueStore::hash(const char *s, int size, quint32 seed)
+{
+    // FNV-1a, then the murmur3 finalizer to spread it over all bits
+    quint64 h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+    for (int i=0; i<size; i++) {
+        h ^= uchar(s[i]);
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+bool ClueStore::load(const QString &fileName)
+{
+    delete m_file;
+    m_file = nullptr;
+    m_header = nullptr;
+
+    QFile *file = new QFile(fileName);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header))) {
+        qWarning() << "Failed to open clues" << fileName;
+        delete file;
+        return false;
+    }
+    const uchar *base = file->map(0, file->size());
+    if (!base) {
+        qWarning() << "Failed to map clues" << fileName;
+        delete file;
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header*>(base);
+    if (memcmp(header->magic, clueMagic, sizeof(clueMagic)) != 0
+            || header->byteorder != byteOrderMark || header->version != version
+            || header->filesize != file->size() || header->nanswers == 0) {
+        qWarning() << "Invalid clue file" << fileName;
+        delete file;
+        return false;
+    }
+    if (!checkLayout(base, *header)) {
+        qWarning() << "Corrupt clue file" << fileName;
+        delete file;
+        return false;
+    }
+
+    m_file = file;
+    m_header = header;
+    m_seeds = reinterpret_cast<const quint32*>(base + header->seedsoff);
+    m_answers = reinterpret_cast<const Answer*>(base + header->answersoff);
+    m_clues = reinterpret_cast<const StringRef*>(base + header->cluesoff);
+    m_lengths = reinterpret_cast<const quint32*>(base + header->lengthsoff);
+    m_byLength = reinterpret_cast<const quint32*>(base + header->bylengthoff);
+    m_strings = reinterpret_cast<const char*>(base + header->stringsoff);
+    qDebug() << "Mapped" << header->nanswers << "answers with" << header->nclues << "clues";
+    return true;
+}
+
+// The sections have to be where write() puts them. Offsets inside the
+// tables are checked when they are used, so nothing is read in full here.
+bool ClueStore::checkLayout(const uchar *base, const Header &h)
+{
+    if (h.nbuckets == 0
+            || h.seedsoff != sizeof(Header)
+            || h.answersoff != h.seedsoff + quint64(h.nbuckets) * sizeof(quint32)
+            || h.cluesoff != h.answersoff + quint64(h.nanswers) * sizeof(Answer)
+            || h.lengthsoff != h.cluesoff + quint64(h.nclues) * sizeof(StringRef)
+            || h.bylengthoff != h.lengthsoff + (quint64(h.maxlength) + 2) * sizeof(quint32)
+            || h.stringsoff != h.bylengthoff + quint64(h.nanswers) * sizeof(quint32)
+            || quint64(h.stringsoff) + h.stringslen != h.filesize) {
+        return false;
+    }
+
+    // the length table is small, it has to count up to all answers
+    const quint32 *lengths = reinterpret_cast<const quint32*>(base + h.lengthsoff);
+    if (lengths[0] != 0 || lengths[h.maxlength + 1] != h.nanswers) {
+        return false;
+    }
+    for (quint32 l=0; l<=h.maxlength; l++) {
+        if (lengths[l + 1] < lengths[l]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ClueStore::View ClueStore::view(const StringRef &ref) const
+{
+    if (ref.offset > m_header->stringslen || ref.size > m_header->stringslen - ref.offset) {
+        return View { "", 0 };
+    }
+    return View { m_strings + ref.offset, int(ref.size) };
+}
+
+int ClueStore::answerCount() const
+{
+    return m_header ? int(m_header->nanswers) : 0;
+}
+
+ClueStore::View ClueStore::answerAt(int index) const
+{
+    if (!m_header || index < 0 || quint32(index) >= m_header->nanswers) {
+        return View { "", 0 };
+    }
+    return view(m_answers[index].word);
+}
+
+int ClueStore::answerCount(int length) const
+{
+    if (!m_header || length < 0 || quint32(length) > m_header->maxlength) {
+        return 0;
+    }
+    return int(m_lengths[length + 1] - m_lengths[length]);
+}
+
+ClueStore::View ClueStore::answerAt(int length, int index) const
+{
+    if (index < 0 || index >= answerCount(length)) {
+        return View { "", 0 };
+    }
+    quint32 slot = m_byLength[m_lengths[length] + index];
+    if (slot >= m_header->nanswers) {
+        return View { "", 0 };
+    }
+    return view(m_answers[slot].word);
+}
+
+// The perfect hash sends every word somewhere, so the slot has to be checked.
+const ClueStore::Answer *ClueStore::find(const char *answer, int size) const
+{
+    if (!m_header) {
+        return nullptr;
+    }
+    quint32 bucket = hash(answer, size, 0) % m_header->nbuckets;
+    const Answer *a = &m_answers[hash(answer, size, m_seeds[bucket]) % m_header->nanswers];
+    View word = view(a->word);
+    if (word.size != size || memcmp(word.data, answer, size) != 0) {
+        return nullptr;
+    }
+    // the clues of a valid answer lie within the clue table
+    if (a->firstclue > m_header->nclues || a->nclues > m_header->nclues - a->firstclue) {
+        return nullptr;
+    }
+    return a;
+}
+
+int ClueStore::clueCount(const char *answer, int size) const
+{
+    const Answer *a = find(answer, size);
+    return a ? int(a->nclues) : 0;
+}
+
+ClueStore::View ClueStore::clue(const char *answer, int size, int index) const
+{
+    const Answer *a = find(answer, size);
+    if (!a || index < 0 || quint32(index) >= a->nclues) {
+        return View { "", 0 };
+    }
+    return view(m_clues[a->firstclue + index]);
+}
+
+//////////////////////////////////////////////////////////////////////
+// building
+
+static std::string trimmed(const std::string &s)
+{
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) {
+        return std::string();
+    }
+    return s.substr(b, s.find_last_not_of(" \t\r\n") - b + 1);
+}
+
+// same cleanup as the old Crossword::parseWordlist, the word is lowercased
+// through QString so non-ASCII letters fold like they used to
+static bool parseLine(const std::string &line, std::string &hint, std::string &word)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= line.size()) {
+        size_t end = line.find('\t', start);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        if (end > start) {
+            parts.push_back(line.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    if (parts.empty()) {
+        return false;
+    }
+
+    hint = trimmed(parts.front());
+    word = trimmed(parts.back());
+    word = QString::fromStdString(word).toLower().toStdString();
+    if (hint.size() >= 2 && hint.front() == '"' && hint.back() == '"') {
+        hint = hint.substr(1, hint.size() - 2);
+    }
+    for (size_t i = hint.find("\"\""); i != std::string::npos; i = hint.find("\"\"", i + 1)) {
+        hint.erase(i, 1);
+    }
+    return !hint.empty() && !word.empty();
+}
+
+class StringTable
+{
+public:
+    ClueStore::StringRef add(const std::string &s) {
+        auto it = m_index.find(s);
+        if (it != m_index.end()) {
+            return it->second;
+        }
+        ClueStore::StringRef ref { quint32(m_blob.size()), quint32(s.size()) };
+        m_blob += s;
+        m_index.emplace(s, ref);
+        return ref;
+    }
+    const std::string &blob() const { return m_blob; }
+
+private:
+    std::string m_blob;
+    std::unordered_map<std::string, ClueStore::StringRef> m_index;
+};
+
+bool ClueStore::build(const std::string &tsvFile, const std::string &clueFile)
+{
+    std::ifstream in(tsvFile.c_str());
+    if (!in) {
+        qWarning() << "Failed to open" << tsvFile.c_str();
+        return false;
+    }
+
+    std::vector<std::pair<std::string, std::string>> clues;
+    std::string line, hint, word;
+    size_t invalid = 0;
+    while (std::getline(in, line)) {
+        if (!parseLine(line, hint, word)) {
+            invalid++;
+            continue;
+        }
+        clues.emplace_back(word, hint);
+    }
+    if (invalid) {
+        qWarning() << "Skipped" << invalid << "invalid lines";
+    }
+    return write(clueFile, clues);
+}
+
+bool ClueStore::write(const std::string &clueFile, const std::vector<std::pair<std::string, std::string>> &input)
+{
+    // answers in the order they are first seen, clues in input order
+    std::vector<std::string> words;
+    std::vector<std::vector<StringRef>> wordClues;
+    std::unordered_map<std::string, quint32> wordIndex;
+    StringTable strings;
+    size_t nclues = 0;
+    for (const auto &pair : input) {
+        const std::string &word = pair.first;
+        if (word.empty() || pair.second.empty()) {
+            continue;
+        }
+        auto it = wordIndex.find(word);
+        if (it == wordIndex.end()) {
+            it = wordIndex.emplace(word, quint32(words.size())).first;
+            words.push_back(word);
+            wordClues.emplace_back();
+        }
+        StringRef ref = strings.add(pair.second);
+        std::vector<StringRef> &clues = wordClues[it->second];
+        if (std::none_of(clues.begin(), clues.end(), [&](const StringRef &r) { return r.offset == ref.offset; })) {
+            clues.push_back(ref);
+            nclues++;
+        }
+    }
+    if (words.empty()) {
+        qWarning() << "No clues for" << clueFile.c_str();
+        return false;
+    }
+
+    // Hash and displace: answers go to buckets by their seed 0 hash, then
+    // the largest buckets first get the first seed that puts all their
+    // answers in free slots.
+    const quint32 nanswers = quint32(words.size());
+    const quint32 nbuckets = nanswers / bucketSize + 1;
+    std::vector<std::vector<quint32>> buckets(nbuckets);
+    for (quint32 i=0; i<nanswers; i++) {
+        buckets[hash(words[i].data(), int(words[i].size()), 0) % nbuckets].push_back(i);
+    }
+    std::vector<quint32> order(nbuckets);
+    for (quint32 b=0; b<nbuckets; b++) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](quint32 a, quint32 b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<quint32> seeds(nbuckets, 0);
+    std::vector<qint64> slotOf(nanswers, -1);
+    std::vector<bool> used(nanswers, false);
+    std::vector<quint32> slots;
+    for (quint32 b : order) {
+        const std::vector<quint32> &bucket = buckets[b];
+        if (bucket.empty()) {
+            break;
+        }
+        quint32 seed = 1;
+        for (; seed < maxSeed; seed++) {
+            slots.clear();
+            for (quint32 i : bucket) {
+                quint32 slot = hash(words[i].data(), int(words[i].size()), seed) % nanswers;
+                if (used[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (slots.size() == bucket.size()) {
+                break;
+            }
+        }
+        if (seed == maxSeed) {
+            qWarning() << "Failed to build the perfect hash";
+            return false;
+        }
+        seeds[b] = seed;
+        for (size_t k=0; k<bucket.size(); k++) {
+            used[slots[k]] = true;
+            slotOf[bucket[k]] = slots[k];
+        }
+    }
+
+    // answer words go to the string table too, after all clues
+    std::vector<Answer> answers(nanswers);
+    std::vector<StringRef> clues;
+    clues.reserve(nclues);
+    for (quint32 i=0; i<nanswers; i++) {
+        Answer &a = answers[slotOf[i]];
+        a.word = strings.add(words[i]);
+        a.firstclue = quint32(clues.size());
+        a.nclues = quint32(wordClues[i].size());
+        clues.insert(clues.end(), wordClues[i].begin(), wordClues[i].end());
+    }
+
+    std::vector<quint32> byLength(nanswers);
+    for (quint32 i=0; i<nanswers; i++) {
+        byLength[i] = i;
+    }
+    std::sort(byLength.begin(), byLength.end(), [&](quint32 a, quint32 b) {
+        if (words[a].size() != words[b].size()) {
+            return words[a].size() < words[b].size();
+        }
+        return words[a] < words[b];
+    });
+    const quint32 maxlength = quint32(words[byLength.back()].size());
+    std::vector<quint32> lengths(maxlength + 2, 0);
+    for (quint32 i=0; i<nanswers; i++) {
+        lengths[words[byLength[i]].size() + 1]++;
+        byLength[i] = quint32(slotOf[byLength[i]]);
+    }
+    for (quint32 l=1; l<lengths.size(); l++) {
+        lengths[l] += lengths[l - 1];
+    }
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, clueMagic, sizeof(clueMagic));
+    h.version = version;
+    h.byteorder = byteOrderMark;
+    h.nanswers = nanswers;
+    h.nclues = quint32(clues.size());
+    h.nbuckets = nbuckets;
+    h.seedsoff = sizeof(Header);
+    h.answersoff = h.seedsoff + nbuckets * sizeof(quint32);
+    h.cluesoff = h.answersoff + nanswers * sizeof(Answer);
+    h.maxlength = maxlength;
+    h.lengthsoff = h.cluesoff + h.nclues * sizeof(StringRef);
+    h.bylengthoff = h.lengthsoff + lengths.size() * sizeof(quint32);
+    h.stringsoff = h.bylengthoff + nanswers * sizeof(quint32);
+    h.stringslen = quint32(strings.blob().size());
+    quint64 filesize = quint64(h.stringsoff) + h.stringslen;
+    if (filesize > 0xffffffffULL) {
+        qWarning() << "Too many clues for one file";
+        return false;
+    }
+    h.filesize = quint32(filesize);
+
+    std::ofstream out(clueFile.c_str(), std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(seeds.data()), seeds.size() * sizeof(quint32));
+    out.write(reinterpret_cast<const char*>(answers.data()), answers.size() * sizeof(Answer));
+    out.write(reinterpret_cast<const char*>(clues.data()), clues.size() * sizeof(StringRef));
+    out.write(reinterpret_cast<const char*>(lengths.data()), lengths.size() * sizeof(quint32));
+    out.write(reinterpret_cast<const char*>(byLength.data()), byLength.size() * sizeof(quint32));
+    out.write(strings.blob().data(), strings.blob().size());
+    out.close();
+    if (!out) {
+        qWarning() << "Failed to write" << clueFile.c_str();
+        return false;
+    }
+    qDebug() << "Wrote" << nanswers << "answers with" << clues.size() << "clues," << filesize << "bytes";
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef CLUESTORE_H
+#define CLUESTORE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <QtGlobal>
+#include <QString>
+#include <QByteArray>
+
+class QFile;
+
+// Read-only clues for answers, memory mapped from a file made by build()
+// or write() (see mkclues.cpp and mkjargon.cpp). Answers are found through a minimal perfect hash and
+// clues come back as views into the mapping, so nothing is parsed or
+// copied at startup and the pages stay shared with the page cache.
+class ClueStore
+{
+public:
+    // a UTF-8 string in the mapped file, valid while the store is loaded
+    struct View {
+        const char *data;
+        int size;
+
+        bool isEmpty() const { return size == 0; }
+        QString toString() const { return QString::fromUtf8(data, size); }
+    };
+
+    ClueStore();
+    ~ClueStore();
+
+    bool load(const QString &fileName);
+    bool isLoaded() const { return m_header != nullptr; }
+
+    int answerCount() const;
+    // answers in hash order, for building a word list from the store
+    View answerAt(int index) const;
+
+    // answers of one length (in bytes) in alphabetical order
+    int maxLength() const { return m_header ? int(m_header->maxlength) : 0; }
+    int answerCount(int length) const;
+    View answerAt(int length, int index) const;
+
+    // answers are lowercase UTF-8
+    int clueCount(const char *answer, int size) const;
+    View clue(const char *answer, int size, int index = 0) const;
+
+    int clueCount(const QByteArray &answer) const { return clueCount(answer.constData(), answer.size()); }
+    View clue(const QByteArray &answer, int index = 0) const { return clue(answer.constData(), answer.size(), index); }
+
+    // converts a tab separated "clue<TAB>answer" file like nyt.tsv
+    static bool build(const std::string &tsvFile, const std::string &clueFile);
+    // writes (answer, clue) pairs, several clues for an answer are kept in order
+    static bool write(const std::string &clueFile, const std::vector<std::pair<std::string, std::string>> &clues);
+
+    static const quint32 version = 2;
+
+    struct StringRef {
+        quint32 offset, size;
+    };
+    struct Answer {
+        StringRef word;
+        quint32 firstclue, nclues;
+    };
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 byteorder;
+        quint32 nanswers, nclues;
+        // one hash seed per bucket, placing its answers in the answer table
+        quint32 nbuckets, seedsoff;
+        // one Answer per hash slot
+        quint32 answersoff;
+        // one StringRef per clue, grouped by answer
+        quint32 cluesoff;
+        // maxlength + 2 offsets into the by length table, one per length
+        quint32 maxlength, lengthsoff;
+        // answer slots by length, then alphabetically
+        quint32 bylengthoff;
+        // the interned strings
+        quint32 stringsoff, stringslen;
+        quint32 filesize;
+    };
+
+    static quint64 hash(const char *s, int size, quint32 seed);
+
+private:
+    static bool checkLayout(const uchar *base, const Header &header);
+    const Answer *find(const char *answer, int size) const;
+    // an empty view if ref points outside the strings
+    View view(const StringRef &ref) const;
+
+    QFile *m_file = nullptr;
+    const Header *m_header = nullptr;
+    const quint32 *m_seeds = nullptr;
+    const Answer *m_answers = nullptr;
+    const StringRef *m_clues = nullptr;
+    const quint32 *m_lengths = nullptr;
+    const quint32 *m_byLength = nullptr;
+    const char *m_strings = nullptr;
+};
+
+#endif // CLUESTORE_H
@@ -1,4 +1,5 @@
 #include "crossword.h"
+#include "puzzlepool.h"
 
 
 // #include "cwc/dict.hh"
@@ -16,16 +17,177 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QCoreApplication>
+#include <QStandardPaths>
 #include <QElapsedTimer>
 #include <QDir>
+#include <QThread>
 
-Crossword::Crossword(QObject *parent) : QObject(parent),
-    m_grid(nullptr)
+class GenerationThread : public QThread
 {
-    // parseWordlist(":/nyt.tsv");
+public:
+    GenerationThread(const Crossword::GenerationJob &job, const std::atomic<bool> &cancelled, Crossword *crossword) :
+        m_job(job), m_cancelled(cancelled), m_crossword(crossword) {}
+
+    QByteArray result() const { return m_result; }
+    qint64 elapsed() const { return m_elapsed; }
+
+protected:
+    void run() override {
+        Crossword *crossword = m_crossword;
+        QElapsedTimer timer;
+        timer.start();
+        m_result = m_job(m_cancelled, [crossword](qreal progress) {
+            QMetaObject::invokeMethod(crossword, "setGenerationProgress", Qt::QueuedConnection, Q_ARG(qreal, progress));
+        });
+        m_elapsed = timer.elapsed();
+    }
+
+private:
+    Crossword::GenerationJob m_job;
+    const std::atomic<bool> &m_cancelled;
+    Crossword *m_crossword;
+    QByteArray m_result;
+    qint64 m_elapsed = 0;
+};
+
+Crossword::Crossword(PuzzlePool *pool, QObject *parent) : QObject(parent),
+    m_pool(pool),
+    m_grid(nullptr),
+    m_cancelled(false)
+{
+    // loadClues("nyt.clues");
+    newGame();
+}
+
+Crossword::~Crossword()
+{
+    if (m_generation) {
+        m_cancelled = true;
+        m_generation->wait();
+        delete m_generation;
+    }
+    delete m_grid;
+}
+
+void Crossword::newGame()
+{
+    if (m_generation) {
+        qDebug() << "Already generating";
+        return;
+    }
+
+    // the pool only grows behind our back, so a non-empty pool won't block
+    if (m_pool && !m_pool->isEmpty() && loadSudoku(m_pool->take())) {
+        emit puzzleChanged();
+        return;
+    }
     generateCrossword();
 }
 
+void Crossword::cancel()
+{
+    if (m_generation && m_generationCancellable) {
+        m_cancelled = true;
+    }
+}
+
+void Crossword::startGeneration(const GenerationJob &job, bool cancellable)
+{
+    m_cancelled = false;
+    m_generationCancellable = cancellable;
+    m_generation = new GenerationThread(job, m_cancelled, this);
+    connect(m_generation, &QThread::finished, this, &Crossword::generationDone);
+    setGenerationProgress(0);
+    m_generation->start(QThread::LowPriority);
+    emit generatingChanged();
+}
+
+void Crossword::setGenerationProgress(qreal progress)
+{
+    if (!m_generation || progress == m_generationProgress) {
+        return;
+    }
+    m_generationProgress = progress;
+    emit generationProgressChanged();
+}
+
+// Back on the GUI thread, so swapping in the new board can't race with QML
+// reading the old one.
+void Crossword::generationDone()
+{
+    QByteArray puzzle = m_generation->result();
+    qint64 elapsed = m_generation->elapsed();
+    m_generation->wait();
+    delete m_generation;
+    m_generation = nullptr;
+
+    bool success = false;
+    if (m_cancelled) {
+        qDebug() << "Generation cancelled after" << elapsed << "ms";
+    } else if (puzzle.isEmpty()) {
+        qWarning() << "Failed to generate puzzle";
+    } else {
+        success = loadSudoku(puzzle);
+        qDebug() << "Generated sudoku in" << elapsed << "ms";
+    }
+
+    emit generatingChanged();
+    if (success) {
+        emit puzzleChanged();
+    }
+    emit generationFinished(success);
+
+    // there is no board to go back to, so try again
+    if (m_cancelled && !m_grid) {
+        newGame();
+    }
+}
+
+QByteArray Crossword::generateSudoku()
+{
+    qqwing::SudokuBoard board;
+    if (!board.generatePuzzle()) {
+        return QByteArray();
+    }
+
+    const int *puzzle = board.getPuzzle();
+    QByteArray ret(81, '\0');
+    for (int i=0; i<81; i++) {
+        ret[i] = char(puzzle[i]);
+    }
+    return ret;
+}
+
+bool Crossword::loadSudoku(const QByteArray &puzzle)
+{
+    if (puzzle.size() != 81) {
+        qWarning() << "Invalid sudoku of size" << puzzle.size();
+        return false;
+    }
+    // the current board keeps its hints until this one is accepted
+    std::array<int,81> hints;
+    for (int i=0; i<81; i++) {
+        if (puzzle[i] < 0 || puzzle[i] > 9) {
+            qWarning() << "Invalid sudoku cell" << i;
+            return false;
+        }
+        hints[i] = puzzle[i];
+    }
+
+    qqwing::SudokuBoard *grid = new qqwing::SudokuBoard();
+    if (!grid->setPuzzle(hints.data())) {
+        qWarning() << "Unsolvable sudoku";
+        delete grid;
+        return false;
+    }
+    delete m_grid;
+    m_grid = grid;
+    m_initialHints = hints;
+    m_puzzleRevision++;
+    return true;
+}
+
 QString Crossword::hintAt(const int index)
 {
     // if (!m_answers) {
@@ -91,7 +253,7 @@ QStringList Crossword::hintsAcross()
     QStringList ret;
     // for (const int &num : m_answers->across.clues) {
     //     QString clue = QString::number(num) + "→: ";
-    //     clue += m_hints[QString::fromStdString(m_answers->across.cluetoanswer[num])];
+    //     clue += m_clues.clue(QByteArray::fromStdString(m_answers->across.cluetoanswer[num])).toString();
     //     ret.append(clue);
     // }
 
@@ -106,7 +268,7 @@ QStringList Crossword::hintsDown()
     QStringList ret;
     // for (const int &num : m_answers->down.clues) {
     //     QString clue = QString::number(num) + "↓: ";
-    //     clue += m_hints[QString::fromStdString(m_answers->down.cluetoanswer[num])];
+    //     clue += m_clues.clue(QByteArray::fromStdString(m_answers->down.cluetoanswer[num])).toString();
     //     ret.append(clue);
     // }
 
@@ -119,60 +281,39 @@ QString Crossword::hintTextAt(int index)
     //     return {};
     // }
     // if (m_answers->across.celltoanswer.find(index) != m_answers->across.celltoanswer.end()) {
-    //     return m_hints[QString::fromStdString(m_answers->across.celltoanswer[index])];
+    //     return m_clues.clue(QByteArray::fromStdString(m_answers->across.celltoanswer[index])).toString();
     // }
     // if (m_answers->down.celltoanswer.find(index) != m_answers->down.celltoanswer.end()) {
-    //     return m_hints[QString::fromStdString(m_answers->down.celltoanswer[index])];
+    //     return m_clues.clue(QByteArray::fromStdString(m_answers->down.celltoanswer[index])).toString();
     // }
     return QString();
 }
 
-void Crossword::parseWordlist(const QString &filePath)
+// Clue files are made from nyt.tsv with mkclues, and looked for in the app
+// data directories first, then next to the binary.
+void Crossword::loadClues(const QString &fileName)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "Failed to load" << filePath;
-        return;
+    QString path = QStandardPaths::locate(QStandardPaths::AppDataLocation, fileName);
+    if (path.isEmpty()) {
+        path = QCoreApplication::applicationDirPath() + "/" + fileName;
     }
+
     QElapsedTimer timer;
     timer.start();
-
-    while (!file.atEnd()) {
-        QString line = file.readLine();
-        QStringList parts = line.split('\t', QString::SkipEmptyParts);
-
-        QString hint = parts.first().trimmed();
-        QString word = parts.last().trimmed().toLower();
-        if (hint.startsWith('"') && hint.endsWith('"')) {
-            hint.remove(0, 1);
-            hint.chop(1);
-        }
-        hint.replace("\"\"", "\"");
-        if (hint.isEmpty() || word.isEmpty())  {
-            qWarning() << "Invalid line";
-            continue;
-        }
-
-        m_hints[word] = hint;
-    }
-    qDebug() << "loaded word list in" << timer.elapsed() << "ms";
-
-    if (m_hints.isEmpty()) {
-        qWarning() << "No words in file";
+    if (!m_clues.load(path)) {
         return;
     }
+    qDebug() << "loaded clues in" << timer.elapsed() << "ms";
 }
 
 void Crossword::generateCrossword()
 {
-    QElapsedTimer timer;
-    timer.start();
-
     // LetterDict dict;
 
     // dict.wl = new WordList;
-    // for (const QString &word : m_hints.keys()) {
-    //     dict.wl->addWord(word.toStdString());
+    // for (int i=0; i<m_clues.answerCount(); i++) {
+    //     ClueStore::View word = m_clues.answerAt(i);
+    //     dict.wl->addWord(std::string(word.data, word.size));
     // }
     // int nwords = dict.wl->numwords();
     // qDebug() << "Added" << nwords << "words";
@@ -220,23 +361,12 @@ void Crossword::generateCrossword()
 
     // delete dict.wl;
 
-    if (m_grid) {
-        qWarning() << "deleting generator";
-        delete m_grid;
-    }
-
-    m_grid = new qqwing::SudokuBoard();
-    bool dunnow = m_grid->generatePuzzle();
-    // std::copy(std::begin(m_initialHints), std::end(m_initialHints), m_grid->getPuzzle());
-    // std::copy(std::begin(m_initialHints), std::end(m_initialHints), m_grid->getPuzzle());
-    m_grid->printPuzzle();
-    memcpy(m_initialHints.data(), m_grid->getPuzzle(), 81*4);
-
-    QString tmp;
-    for (auto i : m_initialHints) {
-        tmp += " " + QString::number(i);
-    }
-    qDebug() << tmp;
+    // qqwing can't be interrupted or report progress, but it doesn't take long
+    startGeneration([](const std::atomic<bool> &, const std::function<void(qreal)> &progress) {
+        QByteArray puzzle = generateSudoku();
+        progress(1);
+        return puzzle;
+    }, false);
 
     // if (m_columns != 9) {
     //     m_columns = 9;
@@ -247,5 +377,4 @@ void Crossword::generateCrossword()
     //     m_rows = 9;
     //     emit rowsChanged();
     // }
-    qDebug() << "Generated sudoku in" << timer.elapsed() << "ms " << dunnow;
 }
@@ -2,10 +2,14 @@
 #define CROSSWORD_H
 
 #include <array>
+#include <atomic>
+#include <functional>
 
 #include <QObject>
+#include <QByteArray>
 #include <QVector>
-#include <QHash>
+
+#include "cluestore.h"
 
 // #include "cwc/grid.hh"
 
@@ -13,23 +17,52 @@ namespace qqwing {
     class SudokuBoard;
 };
 
+class PuzzlePool;
+class GenerationThread;
+
 class Crossword : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(int rows READ rows NOTIFY rowsChanged)
     Q_PROPERTY(int columns READ columns NOTIFY columnsChanged)
+    Q_PROPERTY(int puzzleRevision READ puzzleRevision NOTIFY puzzleChanged)
+    Q_PROPERTY(bool generating READ generating NOTIFY generatingChanged)
+    Q_PROPERTY(qreal generationProgress READ generationProgress NOTIFY generationProgressChanged)
+    Q_PROPERTY(bool generationCancellable READ generationCancellable NOTIFY generatingChanged)
 
 public:
-    explicit Crossword(QObject *parent = nullptr);
+    // Runs on the generation thread. Should give up soon after cancelled is
+    // set, and may report progress between 0 and 1 along the way.
+    typedef std::function<QByteArray(const std::atomic<bool> &cancelled,
+                                     const std::function<void(qreal)> &progress)> GenerationJob;
+
+    explicit Crossword(PuzzlePool *pool = nullptr, QObject *parent = nullptr);
+    ~Crossword();
+
+    // generator for the puzzle pool, the initial hints of a new sudoku
+    static QByteArray generateSudoku();
 
     int rows() const { return m_rows; }
     int columns() const { return m_columns; }
+    // bumped on every new board, for bindings on numberAt() and isFixed()
+    int puzzleRevision() const { return m_puzzleRevision; }
+    bool generating() const { return m_generation != nullptr; }
+    qreal generationProgress() const { return m_generationProgress; }
+    // false for jobs that ignore the cancel flag; cancel() does nothing then
+    bool generationCancellable() const { return m_generation && m_generationCancellable; }
 
 signals:
     void columnsChanged();
     void rowsChanged();
+    void puzzleChanged();
+    void generatingChanged();
+    void generationProgressChanged();
+    void generationFinished(bool success);
 
 public slots:
+    void newGame();
+    void cancel();
+
     QString hintAt(const int index);
     QString numberAt(const int index);
     bool isFixed(const int index);
@@ -39,16 +72,29 @@ public slots:
 
     QString hintTextAt(int index);
 
+private slots:
+    void setGenerationProgress(qreal progress);
+    void generationDone();
+
 private:
-    void parseWordlist(const QString &filePath);
+    void loadClues(const QString &fileName);
     void generateCrossword();
+    void startGeneration(const GenerationJob &job, bool cancellable);
+    bool loadSudoku(const QByteArray &puzzle);
 
-    QHash<QString, QString> m_hints;
+    ClueStore m_clues;
 
     int m_rows = 9;
     int m_columns = 9;
 
+    PuzzlePool *m_pool = nullptr;
     qqwing::SudokuBoard *m_grid = nullptr;
+    int m_puzzleRevision = 0;
+
+    GenerationThread *m_generation = nullptr;
+    std::atomic<bool> m_cancelled;
+    bool m_generationCancellable = false;
+    qreal m_generationProgress = 0;
     // int m_originalSolution[81];
     std::array<int,81> m_initialHints;
 };
@@ -0,0 +1,143 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_ALPHABET_HH
+#define CWC_ALPHABET_HH
+
+#include <atomic>
+#include <mutex>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "main.hh"
+
+#define UNDEF 0x7f
+
+/**
+ * An alphabet maps characters to symbol values and fixes the width of
+ * a symbol set. Values 0, 1 and 2 are always the none ('/'), empty
+ * ('+') and outside (' ') symbols, letters follow.
+ *
+ * AsciiAlphabet is an immutable table built at compile time: 'a' to
+ * 'z' (upper case folds to lower case) in a 32 bit set. Symbol values
+ * do not depend on the word list, and looking a character up is a
+ * single load that is safe from any thread.
+ *
+ * WideAlphabet allocates symbol values as characters are first seen,
+ * like the original symbol table, but takes up to 64 of them and is
+ * safe to grow from several threads. Characters are single bytes, so
+ * word lists for other languages have to be in an 8 bit encoding such
+ * as ISO 8859-1; bytes from 0x80 up count as letters.
+ *
+ * The alphabet is chosen at compile time, define CWC_WIDE_ALPHABET to
+ * build with the wide one.
+ */
+
+//////////////////////////////////////////////////////////////////////
+// bit helpers for both set widths
+
+inline int popcount(unsigned int x) { return __builtin_popcount(x); }
+inline int popcount(unsigned long x) { return __builtin_popcountl(x); }
+inline int popcount(unsigned long long x) { return __builtin_popcountll(x); }
+
+// index of the lowest set bit, x must not be 0
+inline int firstbit(unsigned int x) { return __builtin_ctz(x); }
+inline int firstbit(unsigned long x) { return __builtin_ctzl(x); }
+inline int firstbit(unsigned long long x) { return __builtin_ctzll(x); }
+
+//////////////////////////////////////////////////////////////////////
+// class AsciiAlphabet
+
+struct AsciiTable {
+    unsigned char index[256];
+    char letters[32];
+};
+
+constexpr AsciiTable makeasciitable() {
+    AsciiTable t = {};
+    for (int i = 0; i < 256; i++)
+        t.index[i] = UNDEF;
+    for (int i = 0; i < 32; i++)
+        t.letters[i] = UNDEF;
+    const char special[3] = { '/', '+', ' ' };
+    for (int i = 0; i < 3; i++) {
+        t.index[(unsigned char)special[i]] = i;
+        t.letters[i] = special[i];
+    }
+    for (int i = 0; i < 26; i++) {
+        t.index['a' + i] = 3 + i;
+        t.index['A' + i] = 3 + i;
+        t.letters[3 + i] = 'a' + i;
+    }
+    return t;
+}
+
+struct AsciiAlphabet {
+    typedef uint32_t set_type;
+    // symbol values, and bits needed for one
+    static const int size = 32;
+    static const int bits = 5;
+
+    static constexpr AsciiTable table = makeasciitable();
+
+    static int index(char ch) { return table.index[(unsigned char)ch]; }
+    static char letter(int n) { return table.letters[n]; }
+    static bool isletter(char ch) { return isalpha((unsigned char)ch); }
+    static int count() { return 3 + 26; }
+    static int alloc(char ch);
+    static void reset() {}
+};
+
+//////////////////////////////////////////////////////////////////////
+// class WideAlphabet
+
+class WideAlphabet {
+    // symbol value + 1 per character, 0 while not seen
+    static std::atomic<unsigned char> indices[256];
+    static char letters[64];
+    static std::atomic<int> used;
+    static std::mutex lock;
+    static int add(char ch);
+public:
+    typedef uint64_t set_type;
+    static const int size = 64;
+    static const int bits = 6;
+
+    static int index(char ch) {
+        int n = indices[(unsigned char)ch].load(std::memory_order_acquire);
+        return n ? n - 1 : UNDEF;
+    }
+    static char letter(int n) { return n < used.load(std::memory_order_acquire) ? letters[n] : UNDEF; }
+    static bool isletter(char ch) {
+        return isalpha((unsigned char)ch) || (unsigned char)ch >= 0x80;
+    }
+    static int count() { return used.load(std::memory_order_acquire); }
+    static int alloc(char ch);
+    static void reset();
+};
+
+#ifdef CWC_WIDE_ALPHABET
+typedef WideAlphabet Alphabet;
+#else
+typedef AsciiAlphabet Alphabet;
+#endif
+
+#endif // CWC_ALPHABET_HH
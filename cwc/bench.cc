@@ -0,0 +1,440 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+/**
+ * bench - reproducible dictionary and compiler benchmarks.
+ *
+ * usage: bench [options] <wordlist> <pattern or directory>...
+ *        bench -replay <tracefile> [options] <wordlist>
+ *
+ * Every pattern is filled with every combination of dictionary,
+ * walker and backtracker, once per seed, and the results go to
+ * stdout as JSON: per combination the fill time (median, p95, p99,
+ * over all fills including failed ones), nodes visited, findpossible
+ * calls and how many fills failed. A fill fails when the search is
+ * exhausted or runs out of its budget. Directories are expanded to
+ * the files in them; files that are no grid templates are listed
+ * under "skipped".
+ *
+ * With -record every query the fills make is appended to a trace
+ * file, one "len pos pattern" line per query with '+' for open cells.
+ * -replay times findpossible alone on such a trace, per dictionary,
+ * and checks that all dictionaries give the same answers.
+ *
+ * options:
+ *   -dicts letter,bitmap,dawg,btree,cache,mmap  (default letter,bitmap,dawg)
+ *   -index <file>        index file for the mmap dictionary
+ *   -walkers prefix,flood,hub                    (default prefix,flood)
+ *   -backtrackers naive,smart,conflict           (default all)
+ *   -seeds <n>           seeds 1 to n (default 10)
+ *   -msecs <n>           time budget per fill (default 5000, 0 = none)
+ *   -nodes <n>           node budget per fill (default 0 = none)
+ *   -record <file>       write the query trace
+ *   -reps <n>            passes over a replayed trace (default 5)
+ *   -trace <file>        write the trace buffer when done (builds without NDEBUG)
+ *   -stats <file>        search statistics of every fill as a JSON array
+ *                        (builds with CWC_STATS)
+ *
+ * Add -DCWC_STATS stats.cc timer.cc for -stats.
+ *
+ * g++ -std=c++14 -O2 -DNDEBUG bench.cc tools.cc cwc.cc trace.cc itercompiler.cc grid.cc gridkernel.cc dict.cc letterdict.cc bitmapdict.cc dawgdict.cc cachedict.cc mmapdict.cc wordlist.cc symbol.cc -o bench -lpthread
+ **/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+
+#include "cwc.hh"
+#include "itercompiler.hh"
+#include "cachedict.hh"
+#include "tools.hh"
+
+typedef std::chrono::steady_clock benchclock;
+
+static double msecssince(benchclock::time_point t) {
+    return std::chrono::duration<double, std::milli>(benchclock::now() - t).count();
+}
+
+//////////////////////////////////////////////////////////////////////
+// counting and recording
+
+/**
+ * passes queries on to a dictionary, counting them and writing them
+ * to the trace, if any.
+ */
+class CountingDict : public Dict {
+    Dict &d;
+    std::ostream *trace;
+public:
+    long calls;
+
+    CountingDict(Dict &thedict, std::ostream *thetrace)
+        : d(thedict), trace(thetrace), calls(0) {}
+    void load(const std::string &) {}
+    SymbolSet findpossible(Symbol *s, int len, int pos) {
+        calls++;
+        if (trace) {
+            *trace << len << ' ' << pos << ' ';
+            for (int i = 0; i < len; i++)
+                *trace << (s[i] == Symbol::empty ? '+' : char(s[i]));
+            *trace << '\n';
+        }
+        return d.findpossible(s, len, pos);
+    }
+    int wordid(Symbol *s, int len) { return d.wordid(s, len); }
+    SymbolSet findunused(Symbol *s, int len, int pos, const UsedWords &used) {
+        calls++;
+        return d.findunused(s, len, pos, used);
+    }
+    SymbolSet findscored(Symbol *s, int len, int pos, int *best) {
+        calls++;
+        return d.findscored(s, len, pos, best);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+// statistics and output
+
+struct Summary {
+    double median, p95, p99, max;
+};
+
+// nearest rank percentiles
+static Summary summarize(std::vector<double> v) {
+    Summary s = { 0, 0, 0, 0 };
+    if (v.empty())
+        return s;
+    std::sort(v.begin(), v.end());
+    int n = v.size();
+    s.median = v[(n - 1) / 2];
+    s.p95 = v[std::max(0, int(ceil(0.95 * n)) - 1)];
+    s.p99 = v[std::max(0, int(ceil(0.99 * n)) - 1)];
+    s.max = v[n - 1];
+    return s;
+}
+
+static void putsummary(std::ostream &os, const char *name, const std::vector<double> &v) {
+    Summary s = summarize(v);
+    os << jsonquote(name) << ": {\"median\": " << s.median << ", \"p95\": " << s.p95
+       << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+}
+
+struct Options {
+    std::vector<std::string> dicts, walkers, backtrackers, patterns;
+    std::string wordfile, indexfile, recordfile, replayfile, tracefile, statsfile;
+    int seeds, reps;
+    long msecs, nodes;
+};
+
+//////////////////////////////////////////////////////////////////////
+// fill benchmark
+
+static void benchfills(Options &o, std::ostream &out) {
+    std::vector<Dict*> owned;
+    std::vector<Dict*> dicts;
+    out << "{\"wordlist\": " << jsonquote(o.wordfile) << ", \"seeds\": " << o.seeds
+        << ", \"msecs\": " << o.msecs << ", \"nodes\": " << o.nodes << ",\n \"dicts\": [";
+    for (size_t i = 0; i < o.dicts.size(); i++) {
+        benchclock::time_point t = benchclock::now();
+        dicts.push_back(makedict(o.dicts[i], o.wordfile, o.indexfile, owned));
+        out << (i ? ", " : "") << "{\"name\": " << jsonquote(o.dicts[i])
+            << ", \"loadmsecs\": " << msecssince(t) << "}";
+    }
+    out << "],\n \"runs\": [";
+
+    std::ofstream trace;
+    if (!o.recordfile.empty()) {
+        trace.open(o.recordfile.c_str());
+        if (!trace.is_open())
+            throw error("Failed to create " + o.recordfile);
+    }
+
+#ifdef CWC_STATS
+    std::ofstream stats;
+    bool firststats = true;
+    if (!o.statsfile.empty()) {
+        stats.open(o.statsfile.c_str());
+        if (!stats.is_open())
+            throw error("Failed to create " + o.statsfile);
+        stats << "[";
+    }
+#endif
+
+    std::vector<std::string> files;
+    for (size_t i = 0; i < o.patterns.size(); i++)
+        addpatterns(o.patterns[i], files);
+
+    std::vector<std::string> skipped;
+    bool first = true;
+    for (size_t p = 0; p < files.size(); p++) {
+        Grid pattern;
+        try {
+            if (!loadpattern(files[p], pattern)) {
+                skipped.push_back(files[p]);
+                continue;
+            }
+        } catch (error &e) {
+            skipped.push_back(files[p]);
+            continue;
+        }
+        std::cerr << patternname(files[p]) << std::endl;
+
+        for (size_t di = 0; di < dicts.size(); di++)
+        for (size_t wi = 0; wi < o.walkers.size(); wi++)
+        for (size_t bi = 0; bi < o.backtrackers.size(); bi++) {
+            std::vector<double> msecs, nodes, calls;
+            int failures = 0, timeouts = 0;
+            for (int seed = 1; seed <= o.seeds; seed++) {
+                if (CacheDict *c = dynamic_cast<CacheDict*>(dicts[di]))
+                    c->clear();
+                Grid g(pattern);
+                Walker *w = makewalker(o.walkers[wi], g);
+                Backtracker *bt = makebacktracker(o.backtrackers[bi], g);
+                CountingDict d(*dicts[di], trace.is_open() ? &trace : 0);
+                IterativeCompiler c(g, *w, *bt, d);
+                c.setSeed(seed);
+#ifdef CWC_STATS
+                SearchStats ss;
+                if (stats.is_open())
+                    c.stats = &ss;
+#endif
+
+                benchclock::time_point t = benchclock::now();
+                IterativeCompiler::state_t st = c.run(o.nodes, o.msecs);
+                msecs.push_back(msecssince(t));
+#ifdef CWC_STATS
+                if (stats.is_open()) {
+                    stats << (firststats ? "\n" : ",\n") << "{\"pattern\": " << jsonquote(patternname(files[p]))
+                          << ", \"dict\": " << jsonquote(o.dicts[di])
+                          << ", \"walker\": " << jsonquote(o.walkers[wi])
+                          << ", \"backtracker\": " << jsonquote(o.backtrackers[bi])
+                          << ", \"seed\": " << seed
+                          << ", \"solved\": " << (st == IterativeCompiler::solved ? "true" : "false")
+                          << ", \"stats\":\n";
+                    std::ostringstream os;
+                    ss.writejson(os);
+                    std::string s = os.str();
+                    s.erase(s.find_last_not_of('\n') + 1);
+                    stats << s << "}";
+                    firststats = false;
+                }
+#endif
+                nodes.push_back(c.getNodes());
+                calls.push_back(d.calls);
+                if (st != IterativeCompiler::solved)
+                    failures++;
+                if (!c.finished())
+                    timeouts++;
+                delete bt;
+                delete w;
+            }
+
+            out << (first ? "\n  " : ",\n  ");
+            first = false;
+            out << "{\"pattern\": " << jsonquote(patternname(files[p]))
+                << ", \"cells\": " << pattern.numopen()
+                << ", \"dict\": " << jsonquote(o.dicts[di])
+                << ", \"walker\": " << jsonquote(o.walkers[wi])
+                << ", \"backtracker\": " << jsonquote(o.backtrackers[bi])
+                << ", \"fills\": " << o.seeds
+                << ", \"failures\": " << failures
+                << ", \"timeouts\": " << timeouts
+                << ", \"failurerate\": " << double(failures) / o.seeds << ",\n   ";
+            putsummary(out, "msecs", msecs);
+            out << ",\n   ";
+            putsummary(out, "nodes", nodes);
+            out << ",\n   ";
+            putsummary(out, "findpossible", calls);
+            out << "}";
+        }
+    }
+
+    out << "\n ],\n \"skipped\": [";
+    for (size_t i = 0; i < skipped.size(); i++)
+        out << (i ? ", " : "") << jsonquote(patternname(skipped[i]));
+    out << "]}" << std::endl;
+#ifdef CWC_STATS
+    if (stats.is_open())
+        stats << "\n]" << std::endl;
+#endif
+
+    for (size_t i = owned.size(); i-- > 0; )
+        delete owned[i];
+}
+
+//////////////////////////////////////////////////////////////////////
+// trace replay
+
+struct Query {
+    int len, pos;
+    Symbol s[MAXWORDLEN + 1];
+};
+
+static void readtrace(const std::string &fn, std::vector<Query> &queries) {
+    std::ifstream f(fn.c_str());
+    if (!f.is_open())
+        throw error("Failed to open " + fn);
+    Query q;
+    std::string pattern;
+    while (f >> q.len >> q.pos >> pattern) {
+        if (q.len < 1 || q.len >= MAXWORDLEN || int(pattern.size()) != q.len ||
+            q.pos < 0 || q.pos >= q.len)
+            throw error("Bad trace line in " + fn);
+        for (int i = 0; i < q.len; i++)
+            q.s[i] = Symbol(pattern[i]);
+        q.s[q.len] = Symbol::outside;
+        queries.push_back(q);
+    }
+}
+
+static void benchreplay(Options &o, std::ostream &out) {
+    // chunks are timed as a whole, clock reads would swamp single queries
+    const int chunk = 256;
+    std::vector<Query> queries;
+    std::vector<Dict*> owned;
+    readtrace(o.replayfile, queries);
+
+    out << "{\"trace\": " << jsonquote(o.replayfile) << ", \"queries\": " << queries.size()
+        << ", \"reps\": " << o.reps << ",\n \"dicts\": [";
+
+    std::vector<SymbolSet> expected;
+    for (size_t di = 0; di < o.dicts.size(); di++) {
+        Dict *d = makedict(o.dicts[di], o.wordfile, o.indexfile, owned);
+
+        // one untimed pass to warm up, and to compare answers
+        long mismatches = 0;
+        for (size_t i = 0; i < queries.size(); i++) {
+            SymbolSet ss = d->findpossible(queries[i].s, queries[i].len, queries[i].pos);
+            if (di == 0)
+                expected.push_back(ss);
+            else if (ss != expected[i])
+                mismatches++;
+        }
+
+        std::vector<double> nsecs;
+        double total = 0;
+        for (int r = 0; r < o.reps; r++) {
+            for (size_t i = 0; i < queries.size(); i += chunk) {
+                size_t end = std::min(queries.size(), i + chunk);
+                benchclock::time_point t = benchclock::now();
+                for (size_t j = i; j < end; j++)
+                    d->findpossible(queries[j].s, queries[j].len, queries[j].pos);
+                double ms = msecssince(t);
+                total += ms;
+                nsecs.push_back(ms * 1e6 / (end - i));
+            }
+        }
+
+        out << (di ? ",\n  " : "\n  ") << "{\"name\": " << jsonquote(o.dicts[di])
+            << ", \"mismatches\": " << mismatches
+            << ", \"queriespersec\": " << (total > 0 ? queries.size() * o.reps * 1000.0 / total : 0)
+            << ", ";
+        putsummary(out, "nsecsperquery", nsecs);
+        out << "}";
+    }
+    out << "\n ]}" << std::endl;
+
+    for (size_t i = owned.size(); i-- > 0; )
+        delete owned[i];
+}
+
+//////////////////////////////////////////////////////////////////////
+// main
+
+static void usage(const char *name) {
+    std::cerr << "usage: " << name << " [options] <wordlist> <pattern or directory>..." << std::endl
+              << "       " << name << " -replay <tracefile> [options] <wordlist>" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    Options o;
+    o.dicts = splitlist("letter,bitmap,dawg");
+    o.walkers = splitlist("prefix,flood");
+    o.backtrackers = splitlist("naive,smart,conflict");
+    o.seeds = 10;
+    o.reps = 5;
+    o.msecs = 5000;
+    o.nodes = 0;
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a[0] != '-') {
+            args.push_back(a);
+            continue;
+        }
+        if (i + 1 >= argc)
+            usage(argv[0]);
+        std::string v = argv[++i];
+        if (a == "-dicts") o.dicts = splitlist(v);
+        else if (a == "-walkers") o.walkers = splitlist(v);
+        else if (a == "-backtrackers") o.backtrackers = splitlist(v);
+        else if (a == "-seeds") o.seeds = atoi(v.c_str());
+        else if (a == "-msecs") o.msecs = atol(v.c_str());
+        else if (a == "-nodes") o.nodes = atol(v.c_str());
+        else if (a == "-reps") o.reps = atoi(v.c_str());
+        else if (a == "-index") o.indexfile = v;
+        else if (a == "-record") o.recordfile = v;
+        else if (a == "-replay") o.replayfile = v;
+        else if (a == "-trace") o.tracefile = v;
+#ifdef CWC_STATS
+        else if (a == "-stats") o.statsfile = v;
+#else
+        else if (a == "-stats") {
+            std::cerr << "-stats needs a build with -DCWC_STATS" << std::endl;
+            return EXIT_FAILURE;
+        }
+#endif
+        else usage(argv[0]);
+    }
+    if (args.empty() || o.seeds < 1 || o.reps < 1)
+        usage(argv[0]);
+    o.wordfile = args[0];
+    o.patterns.assign(args.begin() + 1, args.end());
+    if (o.replayfile.empty() && o.patterns.empty())
+        usage(argv[0]);
+
+    // the dictionaries and grids talk on stdout, keep it for the JSON
+    std::ostream out(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    Symbol::buildindex();
+    int status = EXIT_SUCCESS;
+    try {
+        if (!o.replayfile.empty())
+            benchreplay(o, out);
+        else
+            benchfills(o, out);
+    } catch (error &e) {
+        std::cerr << e.what() << std::endl;
+        status = EXIT_FAILURE;
+    }
+    if (!o.tracefile.empty())
+        dumptrace(o.tracefile);
+    return status;
+}
@@ -0,0 +1,309 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <iostream>
+#include <string.h>
+#include <algorithm>
+#include <limits.h>
+
+#include "bitmapdict.hh"
+
+// the bitmaps are processed four 64 bit blocks at a time. With gcc
+// and clang the vector type below is mapped onto whatever the target
+// has (AVX2, SSE2, NEON), otherwise plain scalar code is used.
+#define BLOCKGROUP 4
+
+#if defined(__GNUC__)
+#define HAVE_VECTOR_EXT
+typedef uint64_t blockvec __attribute__((vector_size(8 * BLOCKGROUP)));
+#endif
+
+static int roundup(int n, int m) {
+    return (n + m - 1) / m * m;
+}
+
+/**
+ * acc = AND of maps[0..nmaps) over the blocks [lo, hi), where lo and
+ * hi are multiples of BLOCKGROUP. Returns the number of set bits.
+ */
+static int andbitmaps(uint64_t *acc, const uint64_t **maps, int nmaps,
+                      int lo, int hi) {
+    int survivors = 0;
+#ifdef HAVE_VECTOR_EXT
+    for (int i = lo; i < hi; i += BLOCKGROUP) {
+        blockvec v, m;
+        memcpy(&v, maps[0] + i, sizeof(v));
+        for (int k = 1; k < nmaps; k++) {
+            memcpy(&m, maps[k] + i, sizeof(m));
+            v &= m;
+        }
+        memcpy(acc + i, &v, sizeof(v));
+        for (int j = 0; j < BLOCKGROUP; j++)
+            survivors += __builtin_popcountll(v[j]);
+    }
+#else
+    for (int i = lo; i < hi; i++) {
+        uint64_t v = maps[0][i];
+        for (int k = 1; k < nmaps; k++)
+            v &= maps[k][i];
+        acc[i] = v;
+        for (; v; v &= v - 1)
+            survivors++;
+    }
+#endif
+    return survivors;
+}
+
+// true if a and b share a bit within [lo, hi)
+static bool intersects(const uint64_t *a, const uint64_t *b, int lo, int hi) {
+#ifdef HAVE_VECTOR_EXT
+    for (int i = lo; i < hi; i += BLOCKGROUP) {
+        blockvec va, vb;
+        memcpy(&va, a + i, sizeof(va));
+        memcpy(&vb, b + i, sizeof(vb));
+        va &= vb;
+        uint64_t any = 0;
+        for (int j = 0; j < BLOCKGROUP; j++)
+            any |= va[j];
+        if (any)
+            return true;
+    }
+#else
+    for (int i = lo; i < hi; i++)
+        if (a[i] & b[i])
+            return true;
+#endif
+    return false;
+}
+
+// first bit set in both a and b within [lo, hi), or -1
+static int firstcommon(const uint64_t *a, const uint64_t *b, int lo, int hi) {
+    for (int i = lo; i < hi; i++)
+        if (a[i] & b[i])
+            return i * 64 + __builtin_ctzll(a[i] & b[i]);
+    return -1;
+}
+
+//////////////////////////////////////////////////////////////////////
+// bitmapdict
+
+BitmapDict::BitmapDict() {
+    for (int len = 0; len < MAXWORDLEN; len++) {
+        buckets[len].nwords = 0;
+        buckets[len].nblocks = 0;
+    }
+}
+
+BitmapDict::~BitmapDict() {
+    delete wl;
+}
+
+void BitmapDict::build() {
+    int nwords = wl->numwords();
+
+    local.assign(nwords, -1);
+    for (int i = 0; i < nwords; i++) {
+        int len = wordlen((*wl)[i]);
+        if (len >= MAXWORDLEN)
+            continue;
+        local[i] = buckets[len].nwords++;
+    }
+
+    for (int len = 1; len < MAXWORDLEN; len++) {
+        Bucket &b = buckets[len];
+        b.nblocks = roundup((b.nwords + 63) / 64, BLOCKGROUP);
+        b.offset.assign(len * MAXSYMBOLS, -1);
+        b.lo.assign(len * MAXSYMBOLS, 0);
+        b.hi.assign(len * MAXSYMBOLS, 0);
+        b.symbols.assign(len * b.nwords, 0);
+        b.all.assign(len, 0);
+        b.scores.assign(b.nwords, 0);
+        b.best.assign(len * MAXSYMBOLS, INT_MIN);
+    }
+
+    // first pass: find the symbols used at each position
+    for (int i = 0; i < nwords; i++) {
+        if (local[i] < 0)
+            continue;
+        Symbol *st = (*wl)[i];
+        Bucket &b = buckets[wordlen(st)];
+        b.scores[local[i]] = wl->score(i);
+        for (int pos = 0; pos < int(b.all.size()); pos++) {
+            b.all[pos] |= st[pos].getsymbolset();
+            b.symbols[pos * b.nwords + local[i]] = st[pos].symbvalue();
+            int &best = b.best[pos * MAXSYMBOLS + st[pos].symbvalue()];
+            if (best == INT_MIN)
+                best = wl->score(i);
+        }
+    }
+
+    // second pass: allocate and fill the bitmaps
+    for (int len = 1; len < MAXWORDLEN; len++) {
+        Bucket &b = buckets[len];
+        int nmaps = 0;
+        for (int pos = 0; pos < len; pos++) {
+            for (SymbolSet m = b.all[pos]; m; m &= m - 1)
+                b.offset[pos * MAXSYMBOLS + firstbit(m)] = b.nblocks * nmaps++;
+        }
+        b.bits.assign(size_t(b.nblocks) * nmaps, 0);
+
+        for (int pos = 0; pos < len; pos++) {
+            for (int w = 0; w < b.nwords; w++) {
+                int sym = b.symbols[pos * b.nwords + w];
+                b.bits[b.offset[pos * MAXSYMBOLS + sym] + w / 64] |= uint64_t(1) << (w % 64);
+            }
+            for (SymbolSet m = b.all[pos]; m; m &= m - 1) {
+                int sym = firstbit(m);
+                int off = b.offset[pos * MAXSYMBOLS + sym];
+                int first = 0, last = b.nblocks;
+                while (b.bits[off + first] == 0) first++;
+                while (b.bits[off + last - 1] == 0) last--;
+                b.lo[pos * MAXSYMBOLS + sym] = first / BLOCKGROUP * BLOCKGROUP;
+                b.hi[pos * MAXSYMBOLS + sym] = roundup(last, BLOCKGROUP);
+            }
+        }
+    }
+}
+
+/**
+ * ORs together the symbols at pos of the words set in acc. With few
+ * survivors we look at the words one by one, otherwise we test the
+ * result against the bitmap of each possible symbol.
+ */
+SymbolSet BitmapDict::gather(const Bucket &b, int pos, const uint64_t *acc,
+                             int lo, int hi, int survivors) {
+    SymbolSet all = b.all[pos];
+    SymbolSet ss = 0;
+
+    if (survivors <= 32) {
+        const unsigned char *symbols = &b.symbols[pos * b.nwords];
+        for (int i = lo; i < hi && ss != all; i++) {
+            for (uint64_t v = acc[i]; v; v &= v - 1) {
+                int w = i * 64 + __builtin_ctzll(v);
+                ss |= SymbolSet(1) << symbols[w];
+            }
+        }
+        return ss;
+    }
+
+    for (SymbolSet m = all; m; m &= m - 1) {
+        int sym = firstbit(m);
+        int idx = pos * MAXSYMBOLS + sym;
+        int slo = std::max(lo, b.lo[idx]), shi = std::min(hi, b.hi[idx]);
+        if (intersects(acc, &b.bits[b.offset[idx]], slo, shi))
+            ss |= SymbolSet(1) << sym;
+    }
+    return ss;
+}
+
+SymbolSet BitmapDict::findpossible(Symbol *s, int len, int pos) {
+    return search(s, len, pos, 0, 0);
+}
+
+int BitmapDict::wordid(Symbol *s, int len) {
+    return wl->find(s, len);
+}
+
+SymbolSet BitmapDict::findunused(Symbol *s, int len, int pos, const UsedWords &used) {
+    return search(s, len, pos, &used, 0);
+}
+
+SymbolSet BitmapDict::findscored(Symbol *s, int len, int pos, int *best) {
+    return search(s, len, pos, 0, best);
+}
+
+// the used words, if any, are taken out of the intersection. best, if
+// given, gets the score of the first surviving word of each symbol.
+SymbolSet BitmapDict::search(Symbol *s, int len, int pos, const UsedWords *used, int *best) {
+    if (len == 1) {
+        // as in the letter dictionary
+        for (SymbolSet m = best ? wl->allalpha : 0; m; m &= m - 1)
+            best[firstbit(m)] = INT_MAX;
+        return wl->allalpha;
+    }
+
+    const Bucket &b = buckets[len];
+    if (b.nwords == 0)
+        return 0;
+
+    const uint64_t *maps[len];
+    int nmaps = 0, lo = 0, hi = b.nblocks;
+
+    for (int i = 0; i < len; i++) {
+        if (s[i] == Symbol::empty)
+            continue;
+        int idx = i * MAXSYMBOLS + s[i].symbvalue();
+        if (b.offset[idx] < 0)
+            return 0;
+        maps[nmaps++] = &b.bits[b.offset[idx]];
+        lo = std::max(lo, b.lo[idx]);
+        hi = std::min(hi, b.hi[idx]);
+    }
+
+    if (nmaps == 0) {
+        for (SymbolSet m = best ? b.all[pos] : 0; m; m &= m - 1) {
+            int sym = firstbit(m);
+            best[sym] = b.best[pos * MAXSYMBOLS + sym];
+        }
+        return b.all[pos];
+    }
+    if (lo >= hi)
+        return 0;
+
+    uint64_t acc[b.nblocks];
+    int survivors = andbitmaps(acc, maps, nmaps, lo, hi);
+
+    if (used) {
+        const std::vector<int> &ids = used->list();
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (local[ids[i]] < 0 || wordlen((*wl)[ids[i]]) != len)
+                continue;
+            int w = local[ids[i]];
+            uint64_t bit = uint64_t(1) << (w % 64);
+            if (w / 64 >= lo && w / 64 < hi && (acc[w / 64] & bit)) {
+                acc[w / 64] &= ~bit;
+                survivors--;
+            }
+        }
+    }
+    if (survivors == 0)
+        return 0;
+
+    SymbolSet ss = gather(b, pos, acc, lo, hi, survivors);
+    for (SymbolSet m = best ? ss : 0; m; m &= m - 1) {
+        int idx = pos * MAXSYMBOLS + firstbit(m);
+        int slo = std::max(lo, b.lo[idx]), shi = std::min(hi, b.hi[idx]);
+        best[firstbit(m)] = b.scores[firstcommon(acc, &b.bits[b.offset[idx]], slo, shi)];
+    }
+    return ss;
+}
+
+void BitmapDict::load(const std::string &fn)
+{
+    std::cout << "Loading wordlist and building dictionary... " << std::flush;
+
+    wl = new WordList();
+    wl->minscore = minscore;
+    wl->load(fn);
+    build();
+
+    std::cout << "ok" << std::endl;
+}
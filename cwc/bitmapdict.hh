@@ -0,0 +1,79 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_BITMAPDICT_HH
+#define CWC_BITMAPDICT_HH
+
+#include <vector>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+#include "wordlist.hh"
+
+/**
+ * The bitmap dictionary indexes the same (length, position, symbol)
+ * postings as the letter dictionary, but stores each posting list as
+ * a dense bitmap over the words of one length. findpossible() ANDs
+ * the bitmaps of the fixed positions block by block and ORs together
+ * the symbols the surviving words have at the wanted position.
+ *
+ * Words are numbered per length bucket, so the bitmaps stay as short
+ * as the bucket, in word list order, so the lowest set bit of a map
+ * is its best scoring word. Bitmaps for symbols that never occur are not stored,
+ * and every bitmap remembers its first and last non-zero block so the
+ * intersection only runs over the overlap.
+ */
+
+class BitmapDict : public Dict {
+    struct Bucket {
+        int nwords;
+        int nblocks;
+        // per (pos, symbol): offset into bits or -1, and the block
+        // range [lo, hi) holding set bits
+        std::vector<int> offset, lo, hi;
+        std::vector<uint64_t> bits;
+        // the symbol value of every word at every position, [pos][word]
+        std::vector<unsigned char> symbols;
+        std::vector<SymbolSet> all;
+        // score of every word, and the best one per (pos, symbol)
+        std::vector<int> scores, best;
+    };
+    Bucket buckets[MAXWORDLEN];
+    // number of every word within its bucket
+    std::vector<int> local;
+
+    void build();
+    SymbolSet gather(const Bucket &b, int pos, const uint64_t *acc,
+                     int lo, int hi, int survivors);
+public:
+    WordList *wl = nullptr;
+    BitmapDict();
+    ~BitmapDict();
+    SymbolSet findpossible(Symbol *, int len, int pos);
+    int wordid(Symbol *s, int len);
+    SymbolSet findunused(Symbol *s, int len, int pos, const UsedWords &used);
+    SymbolSet findscored(Symbol *s, int len, int pos, int *best);
+    void load(const std::string &fn);
+private:
+    SymbolSet search(Symbol *s, int len, int pos, const UsedWords *used, int *best);
+};
+
+#endif // CWC_BITMAPDICT_HH
@@ -0,0 +1,109 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <string.h>
+
+#include "cachedict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// cachedict
+
+CacheDict::CacheDict(Dict &thedict, int entries)
+    : d(thedict), hits(0), misses(0) {
+    int nsets = 1;
+    while (nsets * ways < entries)
+        nsets <<= 1;
+    sets.resize(nsets);
+    setmask = nsets - 1;
+    clear();
+}
+
+void CacheDict::load(const std::string &fn) {
+    d.minscore = minscore;
+    d.load(fn);
+    clear();
+}
+
+void CacheDict::clear() {
+    for (size_t i = 0; i < sets.size(); i++) {
+        std::lock_guard<std::mutex> l(locks[i % stripes]);
+        for (int w = 0; w < ways; w++) {
+            sets[i].entry[w].used = false;
+            sets[i].entry[w].referenced = false;
+        }
+        sets[i].hand = 0;
+    }
+    hits = 0;
+    misses = 0;
+}
+
+SymbolSet CacheDict::findpossible(Symbol *s, int len, int pos) {
+    if (len >= MAXWORDLEN)
+        return d.findpossible(s, len, pos);
+
+    // pack length, position and pattern into the key
+    uint64_t key[keywords];
+    memset(key, 0, sizeof(key));
+    key[0] = len | (pos << 5);
+    for (int i = 0; i < len; i++) {
+        int bit = 10 + i * Alphabet::bits;
+        uint64_t v = s[i].symbvalue() & (MAXSYMBOLS - 1);
+        key[bit / 64] |= v << (bit % 64);
+        if (bit % 64 > 64 - Alphabet::bits)
+            key[bit / 64 + 1] |= v >> (64 - bit % 64);
+    }
+
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int i = 0; i < keywords; i++)
+        h = (h ^ key[i]) * 0x100000001b3ull;
+    unsigned int setno = (h ^ (h >> 32)) & setmask;
+    Set &set = sets[setno];
+    std::mutex &lock = locks[setno % stripes];
+
+    {
+        std::lock_guard<std::mutex> l(lock);
+        for (int w = 0; w < ways; w++) {
+            Entry &e = set.entry[w];
+            if (e.used && memcmp(e.key, key, sizeof(key)) == 0) {
+                e.referenced = true;
+                hits++;
+                return e.value;
+            }
+        }
+    }
+
+    misses++;
+    SymbolSet ss = d.findpossible(s, len, pos);
+
+    std::lock_guard<std::mutex> l(lock);
+    // advance the clock hand past recently used entries
+    while (set.entry[set.hand].used && set.entry[set.hand].referenced) {
+        set.entry[set.hand].referenced = false;
+        set.hand = (set.hand + 1) % ways;
+    }
+    Entry &e = set.entry[set.hand];
+    memcpy(e.key, key, sizeof(key));
+    e.value = ss;
+    e.used = true;
+    e.referenced = false;
+    set.hand = (set.hand + 1) % ways;
+    return ss;
+}
@@ -0,0 +1,91 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_CACHEDICT_HH
+#define CWC_CACHEDICT_HH
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * The cache dictionary sits in front of any other dictionary and
+ * remembers the answers to recent findpossible() queries.
+ *
+ * A query is keyed by its length, position and pattern, packed five
+ * bits per symbol. The table is 4-way set associative; within a set
+ * the entry to replace is chosen by CLOCK (second chance), so
+ * entries hit since the hand last passed them survive. Sets are
+ * protected by striped locks, which makes one cache shareable
+ * between compilers running in parallel as long as the underlying
+ * dictionary is safe for concurrent queries.
+ */
+
+class CacheDict : public Dict {
+public:
+    static const int ways = 4;
+    static const int keywords = (MAXWORDLEN * Alphabet::bits + 10 + 63) / 64;
+
+    // the cache holds at least 'entries' answers (rounded up to a
+    // power of two)
+    CacheDict(Dict &thedict, int entries = 1 << 16);
+
+    void load(const std::string &fn);
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    // these go straight to the dictionary
+    int wordid(Symbol *s, int len) { return d.wordid(s, len); }
+    SymbolSet findunused(Symbol *s, int len, int pos, const UsedWords &used) {
+        return d.findunused(s, len, pos, used);
+    }
+    SymbolSet findscored(Symbol *s, int len, int pos, int *best) {
+        return d.findscored(s, len, pos, best);
+    }
+
+    long getHits() { return hits; }
+    long getMisses() { return misses; }
+    void clear();
+
+protected:
+    struct Entry {
+        uint64_t key[keywords];
+        SymbolSet value;
+        bool used;
+        bool referenced;
+    };
+
+    struct Set {
+        Entry entry[ways];
+        int hand;
+    };
+
+    static const int stripes = 64;
+
+    Dict &d;
+    std::vector<Set> sets;
+    unsigned int setmask;
+    std::mutex locks[stripes];
+    std::atomic<long> hits, misses;
+};
+
+#endif // CWC_CACHEDICT_HH
@@ -34,12 +34,16 @@
 #include <set>
 #include <vector>
 #include <list>
+#include <chrono>
 
 #include "timer.hh"
 #include "symbol.hh"
 #include "dict.hh"
 #include "letterdict.hh"
+#include "bitmapdict.hh"
+#include "dawgdict.hh"
 #include "grid.hh"
+#include "trace.hh"
 
 #include "cwc.hh"
 
@@ -51,7 +55,7 @@ Walker::Walker(Grid &thegrid) : current(0), g(thegrid) {
     inited = false;
 }
 
-Cell &Walker::currentCell() {
+Cell Walker::currentCell() {
     if (!inited) throw error("walker not inited");
     return g.cellno(current);
 }
@@ -76,7 +80,9 @@ void Walker::backToOneOf(int no[], int n) {
 
 void Walker::backToOneOf(Backtracker &bt) {
     backward(false); // dont save current
-    while (!bt.stopHere(current))
+    // never back up past the first cell; the backtracker may ask for
+    // cells that were filled before this walker started (locked ones)
+    while (!cellno.empty() && !bt.stopHere(current))
         backward(true); // save all we skip
 }
 
@@ -92,7 +98,7 @@ void Walker::forward() {
 
 void Walker::backward(bool savepreferred) {
     if (!g.cellno(current).isoutside())
-        g.cellno(current).clear(savepreferred);
+        g.clear(current, savepreferred);
     current = cellno.back();
     cellno.pop_back();
 }
@@ -104,7 +110,7 @@ bool Walker::moresteps() {
 void Walker::findnext() {
     int ncells = g.numcells();
     for (int i = 0; i < ncells; i++) {
-        std::cout << i << " " << g.cellno(i).getsymbol().symbvalue() << std::endl;
+        CWC_TRACE(trace_walker, trace_verbose, "scan " << i << " " << g.cellno(i).getsymbol().symbvalue());
         if (g.cellno(i).isempty()) {
             current = i;
             return;
@@ -117,6 +123,27 @@ void Walker::init() {
     findnext();
 }
 
+void Walker::save(std::ostream &os) {
+    os << "walker " << inited << ' ' << current << ' ' << limit
+       << ' ' << cellno.size();
+    for (size_t i = 0; i < cellno.size(); i++)
+        os << ' ' << cellno[i];
+    os << std::endl;
+}
+
+void Walker::restore(std::istream &is) {
+    std::string tag;
+    size_t n;
+    is >> tag >> inited >> current >> limit >> n;
+    if (!is || tag != "walker")
+        throw error("Bad walker state");
+    cellno.resize(n);
+    for (size_t i = 0; i < n; i++)
+        is >> cellno[i];
+    if (!is)
+        throw error("Bad walker state");
+}
+
 //////////////////////////////////////////////////////////////////////
 // class prefix_walker
 
@@ -135,22 +162,21 @@ void FloodWalker::step_forward() {
     for (i = cellno.begin(); i != cellno.end(); i++) {
         int cno = *i;
 
-        int nwords = g.cellno(cno).numwords();
+        int nwords = g.numcellslots(cno);
         for (int w = 0; w < nwords; w++) {
-            Cell &thecell = g.cellno(cno);
-            WordBlock &wb = thecell.getwordblock(w);
-            int pos = thecell.getpos(w);
-            int len = wb.length();
+            int s = g.cellslot(cno, w);
+            int pos = g.cellpos(cno, w);
+            int len = g.slotlength(s);
 
             if (pos > 0) {
-                int cellbefore = wb.getcellno(pos-1);
+                int cellbefore = g.slotcell(s, pos - 1);
                 if (g.cellno(cellbefore).isempty()) {
                     current = cellbefore;
                     return;
                 }
             }
             if (pos < len-1) {
-                int cellafter = wb.getcellno(pos + 1);
+                int cellafter = g.slotcell(s, pos + 1);
                 if (g.cellno(cellafter).isempty()) {
                     current = cellafter;
                     return;
@@ -162,6 +188,20 @@ void FloodWalker::step_forward() {
     findnext();
 }
 
+//////////////////////////////////////////////////////////////////////
+// class hub_walker
+
+void HubWalker::init() {
+    const std::vector<int> &order = g.dependencyorder();
+    for (size_t i = 0; i < order.size(); i++) {
+        if (g.cellno(order[i]).isempty()) {
+            current = order[i];
+            return;
+        }
+    }
+    throw error("No empty cells");
+}
+
 //////////////////////////////////////////////////////////////////////
 // class backtracker
 
@@ -196,34 +236,29 @@ void SmartBacktracker::backtrack(Walker &w) {
          i = next) {
         next = i; next++;
         if ((*i).first <= cpos) {
-            if (setup.debuginfo) std::cout << "removing " << (*i).second << "(from " << (*i).first << ")" << std::endl;
+            CWC_TRACE(trace_backtracker, trace_debug, "removing " << (*i).second << " (from " << (*i).first << ")");
             bt_points.erase(i);
         }
     }
 
     int cno = w.getCurrent();
 
-    Cell &c = g.cellno(cno);
-    int nwords = c.numwords();
+    int nwords = g.numcellslots(cno);
     for (int wno = 0; wno < nwords; wno++) {
-        WordBlock &wb = c.getwordblock(wno);
-        int len = wb.length();
+        int s = g.cellslot(cno, wno);
+        int len = g.slotlength(s);
 
-        int pos = c.getpos(wno);
+        int pos = g.cellpos(cno, wno);
         for (int p = 0; p < len; p++) {
-            if ((p!=pos)&&(wb.getcell(p).isfilled()))
-                bt_points.push_back(cpair(cpos, wb.getcellno(p)));
+            int other = g.slotcell(s, p);
+            if ((p!=pos)&&(g.cellno(other).isfilled())) {
+                bt_points.push_back(cpair(cpos, other));
+                CWC_TRACE(trace_backtracker, trace_debug, "btpoint " << other << " (from " << cpos << ")");
+            }
         }
 
     }
 
-    if (setup.debuginfo) {
-        std::cout << "BTSET:" << std::endl;
-        for (std::list<cpair>::iterator i = bt_points.begin(); i != bt_points.end(); i++)
-            std::cout << " (" << (*i).first << ',' << (*i).second << ")";
-        std::cout << std::endl;
-    }
-
     w.backToOneOf(*this);
 }
 
@@ -239,6 +274,128 @@ bool SmartBacktracker::stopHere(int p) {
     return false;
 }
 
+void SmartBacktracker::save(std::ostream &os) {
+    os << "btpoints " << bt_points.size();
+    for (std::list<cpair>::iterator i = bt_points.begin(); i != bt_points.end(); i++)
+        os << ' ' << (*i).first << ' ' << (*i).second;
+    os << std::endl;
+}
+
+void SmartBacktracker::restore(std::istream &is) {
+    std::string tag;
+    size_t n;
+    is >> tag >> n;
+    if (!is || tag != "btpoints")
+        throw error("Bad backtracker state");
+    bt_points.clear();
+    for (size_t i = 0; i < n; i++) {
+        cpair p;
+        is >> p.first >> p.second;
+        bt_points.push_back(p);
+    }
+    if (!is)
+        throw error("Bad backtracker state");
+}
+
+//////////////////////////////////////////////////////////////////////
+// class conflict_backtracker
+//
+// A cell's conflict set starts out empty. When the cell runs out of
+// letters, the filled cells sharing a word with it are added, and the
+// set is handed to the latest of its cells on the walked path. Cells
+// jumped over lose their sets, as they will be filled from scratch.
+
+ConflictBacktracker::ConflictBacktracker(Grid &thegrid)
+    : Backtracker(thegrid) {
+    int ncells = g.numcells();
+    nblocks = (ncells + 63) / 64;
+    conflicts.assign(size_t(ncells) * nblocks, 0);
+    jumpset.assign(nblocks, 0);
+}
+
+void ConflictBacktracker::backtrack(Walker &w) {
+    int cno = w.getCurrent();
+    uint64_t *cs = conflictset(cno);
+
+    for (int i = 0; i < nblocks; i++) {
+        jumpset[i] = cs[i];
+        cs[i] = 0;
+    }
+
+    int nwords = g.numcellslots(cno);
+    for (int wno = 0; wno < nwords; wno++) {
+        int s = g.cellslot(cno, wno);
+        int len = g.slotlength(s);
+        for (int p = 0; p < len; p++) {
+            int other = g.slotcell(s, p);
+            if (g.cellno(other).isfilled())
+                jumpset[other / 64] |= uint64_t(1) << (other % 64);
+        }
+    }
+    jumpset[cno / 64] &= ~(uint64_t(1) << (cno % 64));
+
+    w.backToOneOf(*this);
+}
+
+bool ConflictBacktracker::stopHere(int p) {
+    uint64_t bit = uint64_t(1) << (p % 64);
+    uint64_t *cs = conflictset(p);
+    if (!(jumpset[p / 64] & bit)) {
+        for (int i = 0; i < nblocks; i++)
+            cs[i] = 0;
+        return false;
+    }
+    // the culprit takes over the rest of the conflict set
+    for (int i = 0; i < nblocks; i++)
+        cs[i] |= jumpset[i];
+    cs[p / 64] &= ~bit;
+    return true;
+}
+
+// only the cells with a non-empty conflict set are written
+void ConflictBacktracker::save(std::ostream &os) {
+    int ncells = g.numcells();
+    std::vector<int> nonempty;
+    for (int c = 0; c < ncells; c++) {
+        uint64_t *cs = conflictset(c);
+        for (int i = 0; i < nblocks; i++) {
+            if (cs[i]) {
+                nonempty.push_back(c);
+                break;
+            }
+        }
+    }
+    os << "conflicts " << nblocks << ' ' << nonempty.size() << std::endl;
+    for (size_t n = 0; n < nonempty.size(); n++) {
+        uint64_t *cs = conflictset(nonempty[n]);
+        os << nonempty[n];
+        for (int i = 0; i < nblocks; i++)
+            os << ' ' << cs[i];
+        os << std::endl;
+    }
+}
+
+void ConflictBacktracker::restore(std::istream &is) {
+    std::string tag;
+    int blocks;
+    size_t n;
+    is >> tag >> blocks >> n;
+    if (!is || tag != "conflicts" || blocks != nblocks)
+        throw error("Bad backtracker state");
+    conflicts.assign(conflicts.size(), 0);
+    for (size_t k = 0; k < n; k++) {
+        int c;
+        is >> c;
+        if (!is || c < 0 || c >= g.numcells())
+            throw error("Bad backtracker state");
+        uint64_t *cs = conflictset(c);
+        for (int i = 0; i < nblocks; i++)
+            is >> cs[i];
+    }
+    if (!is)
+        throw error("Bad backtracker state");
+}
+
 //////////////////////////////////////////////////////////////////////
 // compiler
 //
@@ -246,9 +403,13 @@ bool SmartBacktracker::stopHere(int p) {
 
 Compiler::Compiler(Grid &thegrid, Walker &thewalker,
                    Backtracker &thebacktracker, Dict &thedict)
-    : g(thegrid), w(thewalker), bt(thebacktracker), d(thedict) {
-    g.verbose = verbose = false;
+    : g(thegrid), w(thewalker), bt(thebacktracker), d(thedict),
+      seed(rand()), cancelflag(0), solutions(0) {
+    g.verbose = false;
     findall = false;
+    nodupes = false;
+    scored = false;
+    stats = 0;
 }
 
 #define success true
@@ -258,17 +419,25 @@ Compiler::Compiler(Grid &thegrid, Walker &thewalker,
 // the reclevel trying to compute this cell catches it
 // and others will return.
 
-Timer dtimer;
-
 bool Compiler::compile_rest(double rejected) {
+    // a cancelled run unwinds like a backjump past every level
+    if (isCancelled())
+        return failure;
+
     int c = w.getCurrent();
-    if (verbose)
-        std::cout << "attempting to find solution for " << c << std::endl;
-    SymbolSet ss = g(c).findpossible(d);
+    CWC_TRACE(trace_compiler, trace_debug, "attempting to find solution for " << c);
+    SymbolSet ss = g.findpossible(c, d);
+    if (nodupes)
+        ss &= g.findunused(c, d);
     int npossible = numones(ss);
     rejected += (numalpha-double(npossible)) * pow(numalpha, numcells - w.stepCount());
-    if (verbose)
-        dumpset(ss);
+    CWC_COUNT(stats, domain(c, npossible));
+    CWC_TRACE(trace_compiler, trace_debug, "possible " << setstring(ss));
+
+    int score[MAXSYMBOLS];
+    if (scored)
+        g.scoreletters(c, d, score);
+    auto nextbit = [&]() { return scored ? pickbest(ss, score, &seed) : pickbit(ss, &seed); };
 
     SymbolSet bit;
     // use preferred if any
@@ -280,12 +449,21 @@ bool Compiler::compile_rest(double rejected) {
             ss &= ~bit; // remove bit from set
         }
         else
-            bit = pickbit(ss);
+            bit = nextbit();
     } else
-        bit = pickbit(ss);
-    for (; bit; bit=pickbit(ss)) {
+        bit = nextbit();
+
+    // every letter tried here starts from the same grid
+    size_t mark = g.mark();
+
+    for (; bit; bit=nextbit()) {
         Symbol s = Symbol::symbolbit(bit);
-        g(c).setsymbol(s);
+        g.setsymbol(c, s);
+        CWC_COUNT(stats, node(w.stepCount()));
+        if (nodupes && !g.claimwords(c, d)) {
+            g.rollback(mark, false);
+            continue;
+        }
         if (w.moresteps()) {
             w.forward();
             if (compile_rest(rejected) == success) return success;
@@ -294,38 +472,102 @@ bool Compiler::compile_rest(double rejected) {
             rejected += pow(numalpha, numcells - w.stepCount());
         } else {
             this->rejected = rejected;
-            return success;
+            CWC_COUNT(stats, solution());
+            if (!findall)
+                return success;
+            // count the fill and go on with the next letter
+            solutions++;
         }
-        g(c).setsymbol(Symbol::empty);
+        // the cells skipped on the way back keep their preferred letters
+        g.rollback(mark, false);
     }
     if (w.stepCount() > 1) {
+        CWC_COUNT(stats, backtrack(w.stepCount()));
         bt.backtrack(w);
-        int cur = w.getCurrent();
-        if (verbose)
-            std::cout << "return to " << cur << " from " << c << std::endl;
+        CWC_COUNT(stats, backjump(w.stepCount()));
+        CWC_TRACE(trace_compiler, trace_debug, "return to " << w.getCurrent() << " from " << c);
     }
     return failure;
 }
 
 bool Compiler::compile() {
-    dtimer.reset(); dtimer.start();
     w.forward();
     numcells = g.numopen();
     numalpha = Symbol::numalpha();
-    return compile_rest();
+    solutions = 0;
+    if (nodupes && !g.claimall(d))
+        return false; // the given words repeat already
+    g.stats = stats;
+    CWC_COUNT(stats, start());
+    CWC_TRACE(trace_compiler, trace_info, "compiling " << numcells << " cells");
+    bool ok = compile_rest();
+    CWC_TRACE(trace_compiler, trace_info, (ok ? "solved" : "failed") << ", " << solutions << " solutions");
+    CWC_COUNT(stats, stop());
+    g.stats = 0;
+    if (findall)
+        return solutions > 0;
+    return ok;
+}
+
+//////////////////////////////////////////////////////////////////////
+// dictionary benchmark
+
+/**
+ * times a fixed mix of queries against d and returns the msecs taken.
+ * For every word length a pattern is filled in one random position at
+ * a time with letters the dictionary offers, querying each position on
+ * the way, so the queries look like those of a compilation and the
+ * same dictionary contents always give the same queries.
+ */
+int dictbench(Dict &d) {
+    const int rounds = 2000;
+    unsigned int seed = 1;
+    Symbol s[MAXWORDLEN];
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (int len = 2; len < 16; len++) {
+            for (int i = 0; i < len; i++)
+                s[i] = Symbol::empty;
+            s[len] = Symbol::outside;
+            for (int n = 0; n < len; n++) {
+                int pos = rand_r(&seed) % len;
+                if (!(s[pos] == Symbol::empty))
+                    continue;
+                SymbolSet ss = d.findpossible(s, len, pos);
+                if (!ss)
+                    break;
+                s[pos] = Symbol::symbolbit(pickbit(ss, &seed));
+            }
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void dodictbench() {
+    Dict *dicts[] = { new BtreeDict(), new LetterDict(), new BitmapDict(), new DawgDict() };
+    const char *names[] = { "binary tree", "letter", "bitmap", "dawg" };
+    for (int i = 0; i < 4; i++) {
+        std::cout << "Benchmarking " << names[i] << " index" << std::endl;
+        dicts[i]->load(setup.dictfile);
+        std::cout << dictbench(*dicts[i]) << " msecs" << std::endl;
+        delete dicts[i];
+    }
 }
 
 //////////////////////////////////////////////////////////////////////
 // main
 
+std::string setstring(SymbolSet ss) {
+    std::string str = "{";
+    for (; ss; ss &= ss - 1)
+        str += Symbol::letter(firstbit(ss));
+    return str + '}';
+}
+
 void dumpset(SymbolSet ss) {
-    int i,n;
-    std::cout << '{';
-    for (i=1, n = 0; i; i<<=1, n++) {
-        if (ss&i)
-            std::cout << Symbol::alphabet[n];
-    }
-    std::cout << '}' << std::endl;
+    std::cout << setstring(ss) << std::endl;
 }
 
 void dumpsymbollist(Symbol *s, int n) {
@@ -27,6 +27,8 @@
 
 #include <map>
 #include <list>
+#include <atomic>
+#include <stdint.h>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -49,11 +51,15 @@ public:
     void backToOneOf(int dest[], int n);
     void backToOneOf(Backtracker &bt);
     int getCurrent() { return current; }
-    Cell &currentCell();
+    Cell currentCell();
     void forward();
     void backward(bool savepreferred = false);
     int stepCount() { return cellno.size() + 1; }
 
+    // the walked path, for suspending a search and picking it up later
+    void save(std::ostream &os);
+    void restore(std::istream &is);
+
 protected:
     /**
      * new walkers _must_ implement step_forward(). init() and findnext()
@@ -94,6 +100,16 @@ protected:
     void step_forward();
 };
 
+// floods like FloodWalker, but starts from the empty cell with the
+// most dependent cells (see Grid::dependencyorder()) instead of the
+// first one
+class HubWalker : public FloodWalker {
+public:
+    HubWalker(Grid &g) : FloodWalker(g) {}
+protected:
+    void init();
+};
+
 //////////////////////////////////////////////////////////////////////
 
 class Backtracker {
@@ -106,6 +122,9 @@ public:
     // a cell where a new solution should be tried.
     virtual void backtrack(Walker &w) =  0;
     virtual bool stopHere(int p) = 0;
+    // state kept between dead ends, if any
+    virtual void save(std::ostream & /*os*/) {}
+    virtual void restore(std::istream & /*is*/) {}
 };
 
 class NaiveBacktracker : public Backtracker {
@@ -124,6 +143,28 @@ public:
     SmartBacktracker(Grid &thegrid) : Backtracker(thegrid) {}
     void backtrack(Walker &w) override;
     bool stopHere(int p) override;
+    void save(std::ostream &os) override;
+    void restore(std::istream &is) override;
+};
+
+/**
+ * conflict-directed backjumping. Every cell carries the set of cells
+ * whose values ruled out letters for it. On a dead end the walker
+ * jumps straight back to the most recent cell in that set, which
+ * inherits the rest of the set as its own reason to fail.
+ */
+class ConflictBacktracker : public Backtracker {
+    int nblocks;
+    // one bit per cell for every cell, nblocks words per set
+    std::vector<uint64_t> conflicts;
+    std::vector<uint64_t> jumpset;
+    uint64_t *conflictset(int cno) { return &conflicts[cno * nblocks]; }
+public:
+    ConflictBacktracker(Grid &thegrid);
+    void backtrack(Walker &w) override;
+    bool stopHere(int p) override;
+    void save(std::ostream &os) override;
+    void restore(std::istream &is) override;
 };
 
 class Compiler {
@@ -135,13 +176,30 @@ protected:
     Walker &w;
     Backtracker &bt;
     Dict &d;
+    unsigned int seed;
+    std::atomic<bool> *cancelflag;
+    long solutions;
     bool compile_rest(double rejected = 0);
 public:
     Compiler(Grid &thegrid, Walker &thewalker, Backtracker &thebacktracker, Dict &thedict);
     bool compile();
 
-    bool verbose, findall, showsteps;
+    bool findall, showsteps;
+    // no word may fill two slots. Needs a dictionary with word ids.
+    bool nodupes;
+    // try the letters of the best scored words first, see Dict::findscored
+    bool scored;
+    // counts the search when built with CWC_STATS, see stats.hh
+    SearchStats *stats;
     double getRejected() { return rejected; }
+    // number of complete fills seen when findall is set
+    long getSolutions() { return solutions; }
+
+    // each compiler draws its letters from its own random state
+    void setSeed(unsigned int s) { seed = s; }
+    // compile() gives up as soon as *flag becomes true
+    void setCancelFlag(std::atomic<bool> *flag) { cancelflag = flag; }
+    bool isCancelled() { return cancelflag && cancelflag->load(std::memory_order_relaxed); }
 };
 
 void dodictbench();
@@ -0,0 +1,228 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <string.h>
+
+#include "dawgdict.hh"
+#include "wordlist.hh"
+
+//////////////////////////////////////////////////////////////////////
+// dawg construction
+//
+// The words of one length are added in sorted order (Daciuk et al.,
+// "Incremental construction of minimal acyclic finite-state
+// automata"). Only the path of the last word is still mutable; once
+// a later word branches off, the part of the path below the branch
+// point is final and gets replaced by an equal node already in the
+// arena, or appended to it.
+
+namespace {
+
+// arena values taken by the symbol mask of a node
+const int maskwords = sizeof(SymbolSet) / sizeof(uint32_t);
+
+inline SymbolSet loadmask(const uint32_t *p) {
+    SymbolSet mask;
+    memcpy(&mask, p, sizeof(mask));
+    return mask;
+}
+
+struct PendingNode {
+    SymbolSet mask;
+    std::vector<uint32_t> children;
+    PendingNode() : mask(0) {}
+};
+
+class DawgBuilder {
+    std::vector<uint32_t> &arena;
+    std::unordered_map<std::string, uint32_t> registry;
+    std::vector<PendingNode> path;
+    std::vector<int> pathsyms;
+    int len;
+public:
+    int nodes;
+
+    DawgBuilder(std::vector<uint32_t> &a, int l)
+        : arena(a), path(l + 1), pathsyms(l, -1), len(l), nodes(0) {}
+
+    uint32_t store(const PendingNode &n) {
+        std::string key((const char *)&n.mask, sizeof(n.mask));
+        if (!n.children.empty())
+            key.append((const char *)&n.children[0], n.children.size() * sizeof(uint32_t));
+        std::unordered_map<std::string, uint32_t>::iterator i = registry.find(key);
+        if (i != registry.end())
+            return i->second;
+        uint32_t off = arena.size();
+        arena.resize(off + maskwords);
+        memcpy(&arena[off], &n.mask, sizeof(n.mask));
+        arena.insert(arena.end(), n.children.begin(), n.children.end());
+        registry[key] = off;
+        nodes++;
+        return off;
+    }
+
+    // freezes the path below depth 'keep' into the arena
+    void freeze(int keep) {
+        for (int d = len - 1; d >= keep; d--) {
+            if (pathsyms[d] < 0)
+                continue;
+            // the child at depth d+1 is final now; link it in
+            uint32_t child = (d + 1 == len) ? 0 : store(path[d + 1]);
+            path[d].children.push_back(child);
+            path[d + 1] = PendingNode();
+            pathsyms[d] = -1;
+        }
+    }
+
+    void add(Symbol *w) {
+        int common = 0;
+        while (common < len && pathsyms[common] == w[common].symbvalue())
+            common++;
+        if (common == len)
+            return; // duplicate
+        freeze(common);
+        for (int d = common; d < len; d++) {
+            int sym = w[d].symbvalue();
+            path[d].mask |= SymbolSet(1) << sym;
+            pathsyms[d] = sym;
+        }
+    }
+
+    uint32_t finish() {
+        freeze(0);
+        return store(path[0]);
+    }
+};
+
+struct SymbolLess {
+    int len;
+    SymbolLess(int l) : len(l) {}
+    bool operator()(Symbol *a, Symbol *b) const {
+        for (int i = 0; i < len; i++) {
+            if (a[i].symbvalue() != b[i].symbvalue())
+                return a[i].symbvalue() < b[i].symbvalue();
+        }
+        return false;
+    }
+};
+
+}
+
+//////////////////////////////////////////////////////////////////////
+// dawgdict
+
+DawgDict::DawgDict() : numnodes(0) {
+    // offset 0 is the final node shared by all words
+    arena.assign(maskwords, 0);
+    for (int i = 0; i < MAXWORDLEN; i++)
+        roots[i] = 0;
+}
+
+int DawgDict::size() {
+    return arena.size() * sizeof(uint32_t);
+}
+
+void DawgDict::build(std::vector<Symbol*> &words, int len) {
+    std::sort(words.begin(), words.end(), SymbolLess(len));
+    DawgBuilder b(arena, len);
+    for (size_t i = 0; i < words.size(); i++)
+        b.add(words[i]);
+    roots[len] = b.finish();
+    numnodes += b.nodes;
+}
+
+void DawgDict::load(const std::string &fn) {
+    std::cout << "Loading wordlist and building dictionary... " << std::flush;
+
+    WordList wl;
+    wl.minscore = minscore;
+    wl.load(fn);
+
+    std::vector<Symbol*> bylen[MAXWORDLEN];
+    int nwords = wl.numwords();
+    for (int i = 0; i < nwords; i++) {
+        int len = wordlen(wl[i]);
+        if (len < MAXWORDLEN)
+            bylen[len].push_back(wl[i]);
+    }
+
+    // every symbol used is a word of length one, like in BtreeDict
+    Symbol single[MAXSYMBOLS];
+    bylen[1].clear();
+    for (SymbolSet m = wl.allalpha; m; m &= m - 1) {
+        single[bylen[1].size()] = Symbol::symbolbit(m & -m);
+        bylen[1].push_back(&single[bylen[1].size()]);
+    }
+
+    for (int len = 1; len < MAXWORDLEN; len++) {
+        if (!bylen[len].empty())
+            build(bylen[len], len);
+    }
+
+    std::cout << "ok" << std::endl;
+    std::cout << numnodes << " nodes, " << size() << " bytes." << std::endl;
+}
+
+bool DawgDict::walk(uint32_t node, Symbol *s, int depth, int len, int pos,
+                    SymbolSet &ss) {
+    if (depth == len)
+        return true;
+
+    SymbolSet mask = loadmask(&arena[node]);
+    const uint32_t *children = &arena[node + maskwords];
+
+    if (!(s[depth] == Symbol::empty)) {
+        SymbolSet bit = s[depth].getsymbolset();
+        if (!(mask & bit))
+            return false;
+        return walk(children[popcount(mask & (bit - 1))], s, depth + 1, len, pos, ss);
+    }
+
+    bool any = false;
+    int n = 0;
+    for (SymbolSet m = mask; m; m &= m - 1, n++) {
+        SymbolSet bit = m & -m;
+        // at pos, symbols already known to fit need no second look
+        if (depth == pos && (ss & bit))
+            continue;
+        if (walk(children[n], s, depth + 1, len, pos, ss)) {
+            if (depth == pos)
+                ss |= bit;
+            any = true;
+            // past pos only existence matters
+            if (depth > pos)
+                break;
+        }
+    }
+    return any;
+}
+
+SymbolSet DawgDict::findpossible(Symbol *s, int len, int pos) {
+    SymbolSet ss = 0;
+    if (len >= MAXWORDLEN || roots[len] == 0)
+        return 0;
+    walk(roots[len], s, 0, len, pos, ss);
+    return ss;
+}
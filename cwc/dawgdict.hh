@@ -0,0 +1,58 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_DAWGDICT_HH
+#define CWC_DAWGDICT_HH
+
+#include <vector>
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * The dawg dictionary holds one minimal directed acyclic word graph
+ * per word length. Words sharing a suffix share the nodes for it.
+ *
+ * All nodes live in a single arena of 32 bit values. A node is its
+ * symbol mask (one arena value, two with the wide alphabet) followed
+ * by one arena offset per child, ordered by symbol value, so the
+ * child for symbol k is found at popcount(mask & ((1 << k) - 1))
+ * past the mask without searching. The final node of every word is
+ * the childless node at offset 0.
+ */
+
+class DawgDict : public Dict {
+    std::vector<uint32_t> arena;
+    uint32_t roots[MAXWORDLEN];
+
+    void build(std::vector<Symbol*> &words, int len);
+    bool walk(uint32_t node, Symbol *s, int depth, int len, int pos,
+              SymbolSet &ss);
+public:
+    DawgDict();
+    void load(const std::string &fn);
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+    // size of the arena in bytes
+    int size();
+    int numnodes;
+};
+
+#endif // CWC_DAWGDICT_HH
@@ -22,6 +22,7 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <limits.h>
 
 #include <stdint.h>
 
@@ -29,6 +30,7 @@
 
 #include "symbol.hh"
 #include "dict.hh"
+#include "wordlist.hh"
 
 //////////////////////////////////////////////////////////////////////
 // class symbollink
@@ -49,7 +51,7 @@ SymbolLink *SymbolLink::addlink(Symbol s) {
 
 void SymbolLink::addword(Symbol *str, int n) {
     if (n == 0) return;
-    if (!isalpha(str[0]))
+    if (!Symbol::isletter(str[0]))
         throw error("!!!");
     SymbolLink *sl = getlink(str[0]);
     if (sl == 0)
@@ -126,12 +128,48 @@ void SymbolLink::dump(char *prefix, int len) {
 //////////////////////////////////////////////////////////////////////
 // dict
 
-Dict::Dict() {
+Dict::Dict() : minscore(INT_MIN) {
 }
 
 Dict::~Dict() {
 }
 
+SymbolSet Dict::findscored(Symbol *s, int len, int pos, int *best) {
+    SymbolSet ss = findpossible(s, len, pos);
+    for (SymbolSet m = ss; m; m &= m - 1)
+        best[firstbit(m)] = 0;
+    return ss;
+}
+
+//////////////////////////////////////////////////////////////////////
+// usedwords
+
+void UsedWords::set(int id) {
+    if (test(id))
+        return;
+    if (size_t(id / 64) >= bits.size())
+        bits.resize(id / 64 + 1, 0);
+    bits[id / 64] |= uint64_t(1) << (id % 64);
+    ids.push_back(id);
+}
+
+void UsedWords::reset(int id) {
+    if (!test(id))
+        return;
+    bits[id / 64] &= ~(uint64_t(1) << (id % 64));
+    for (size_t i = ids.size(); i-- > 0; ) {
+        if (ids[i] == id) {
+            ids.erase(ids.begin() + i);
+            break;
+        }
+    }
+}
+
+void UsedWords::clear() {
+    bits.clear();
+    ids.clear();
+}
+
 //////////////////////////////////////////////////////////////////////
 // btree_dict
 
@@ -153,32 +191,33 @@ void BtreeDict::load(const std::string &fn) {
 
     std::ifstream f(fn.c_str());
     if (!f.is_open()) throw error("Failed to open dictionary file");
-    char sz[256];
+    std::string line, word;
+    int score;
     int wordcount = 0, wordsused = 0;
-    while (f.getline(sz, 256), !f.eof()) {
+    while (std::getline(f, line)) {
         wordcount++;
-        int wlen = strlen(sz);
-        if (sz[wlen-1]=='\n')
-            sz[--wlen] = '\0';
+        if (!WordList::parseline(line, word, score) || score < minscore)
+            continue;
+        int wlen = word.length();
 
-        bool ok = true;
+        bool ok = wlen > 0 && wlen < MAXWORDLEN;
         for (int i=0;i<wlen;i++) {
-            sz[i] = tolower(sz[i]);
-            if (!isalpha(sz[i])) {
+            word[i] = tolower((unsigned char)word[i]);
+            if (!Symbol::isletter(word[i])) {
                 ok = false;
             }
         }
         if (ok) {
             Symbol *symbs = new Symbol[wlen];
             for (int i=0;i<wlen;i++) {
-                symbs[i] = sz[i];
-                chset[uint8_t(sz[i])] = true;
+                symbs[i] = word[i];
+                chset[uint8_t(word[i])] = true;
             }
             addWord(symbs, wlen);
             wordsused++;
             delete[] symbs;
         } else {
-            // cout << "rejecting " << sz << endl;
+            // cout << "rejecting " << word << endl;
         }
 
     }
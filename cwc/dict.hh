@@ -22,10 +22,30 @@
 #ifndef CWC_DICT_HH
 #define CWC_DICT_HH
 
+#include <vector>
+#include <stdint.h>
 #include "symbol.hh"
 
 //////////////////////////////////////////////////////////////////////
 
+/**
+ * a set of word ids, for keeping the words of a fill apart. Ids are
+ * usually added and removed last in first out.
+ */
+class UsedWords {
+    std::vector<uint64_t> bits;
+    std::vector<int> ids;
+public:
+    bool test(int id) const {
+        return size_t(id / 64) < bits.size() && ((bits[id / 64] >> (id % 64)) & 1);
+    }
+    void set(int id);
+    void reset(int id);
+    void clear();
+    // the ids in the set
+    const std::vector<int> &list() const { return ids; }
+};
+
 struct SymbolLink {
     Symbol symb;
     static int instancecount;
@@ -45,6 +65,24 @@ public:
 
     virtual void load(const std::string &fn) = 0;
     virtual SymbolSet findpossible(Symbol *s, int len, int pos) = 0;
+
+    // id of a complete word, or -1 if it is not in the dictionary or
+    // the dictionary has no word ids
+    virtual int wordid(Symbol * /*s*/, int /*len*/) { return -1; }
+    // as findpossible(), leaving out the words in used. Dictionaries
+    // without word ids leave out nothing.
+    virtual SymbolSet findunused(Symbol *s, int len, int pos, const UsedWords & /*used*/) {
+        return findpossible(s, len, pos);
+    }
+    // as findpossible(), also setting best[symbol value] for every
+    // possible symbol to the best score of the words giving it.
+    // best has MAXSYMBOLS entries. Dictionaries without scores give
+    // every symbol the same score.
+    virtual SymbolSet findscored(Symbol *s, int len, int pos, int *best);
+
+    // words scoring below minscore are left out by load(); INT_MIN,
+    // the default, keeps them all
+    int minscore;
 };
 
 class BtreeDict : public Dict {
@@ -0,0 +1,479 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+/**
+ * generate - fills crosswords in bulk, without the app.
+ *
+ * usage: generate [options] <wordlist> <pattern or directory>...
+ *
+ * Fills -count puzzles on -threads threads and writes them as JSON
+ * lines, in id order:
+ *
+ *   {"id": 7, "pattern": "5x5", "seed": 8, "width": 5, "height": 5,
+ *    "rows": ["abcde", ...], "across": [[1, "abcde"], ...],
+ *    "down": [[1, "a...."], ...], "nodes": 812, "msecs": 1.9}
+ *
+ * Attempt n fills pattern n modulo the number of patterns with seed
+ * -seed + n, so a puzzle only depends on its id. Finished attempts are
+ * held back until all lower ids are in, and the first -count that
+ * succeed are written, so the output is the same on any number of
+ * threads unless an attempt runs out of -msecs (never with -msecs 0).
+ * Attempts that fail (no fill, or out of -msecs) are counted but not
+ * written; the run stops short after trying -attempts ids. A summary
+ * with the throughput goes to stderr. Directories are expanded to the
+ * grid templates in them.
+ *
+ * The cell filler is an IterativeCompiler with -walker and
+ * -backtracker, and runs -threads attempts at once. The parallel
+ * filler is a ParallelCompiler, which runs one attempt at a time on
+ * all -threads threads; its fills don't depend on the thread count
+ * either, but it counts no nodes. The portfolio filler races -threads
+ * compilers with different walkers, backtrackers and seeds on one
+ * attempt and keeps the first fill, so its output varies from run to
+ * run. The word filler is a WordFiller over the word list, placing
+ * whole words; it runs -threads attempts at once like the cell filler.
+ *
+ * Every fill is checked against the dictionary (and for duplicates with
+ * -nodupes) before it is written. Bad fills and attempts that throw an
+ * error are reported on stderr and make generate fail.
+ *
+ * options:
+ *   -count <n>           puzzles to write (default 100)
+ *   -threads <n>         worker threads (default one per hardware thread)
+ *   -filler <name>       cell, parallel, portfolio or word (default cell)
+ *   -dict <name>         letter, bitmap, dawg, cache or mmap (default bitmap)
+ *   -index <file>        index file for the mmap dictionary
+ *   -walker <name>       prefix, flood or hub (default flood)
+ *   -backtracker <name>  naive, smart or conflict (default conflict)
+ *   -seed <n>            seed of attempt 0 (default 1)
+ *   -msecs <n>           time budget per attempt (default 10000, 0 = none)
+ *   -attempts <n>        give up after n attempts (default 4 * count + 100)
+ *   -nodupes             no word twice in a puzzle (letter and bitmap with the
+ *                        cell filler, any dictionary with the word filler)
+ *   -minscore <n>        leave out words scored below n ("word;score" lists)
+ *   -scored              try the letters of the best scored words first (cell filler)
+ *   -o <file>            output file (default stdout)
+ *   -trace <file>        write the trace buffer when done (builds without NDEBUG)
+ *   -stats <file>        search statistics of every attempt as a JSON array,
+ *                        in id order (cell filler, builds with CWC_STATS)
+ *
+ * Add -DCWC_STATS stats.cc timer.cc for -stats.
+ *
+ * g++ -std=c++14 -O2 -DNDEBUG generate.cc tools.cc cwc.cc trace.cc itercompiler.cc parallelcompiler.cc portfolio.cc wordfill.cc grid.cc gridkernel.cc dict.cc letterdict.cc bitmapdict.cc dawgdict.cc cachedict.cc mmapdict.cc wordlist.cc symbol.cc -o generate -lpthread
+ **/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "cwc.hh"
+#include "itercompiler.hh"
+#include "parallelcompiler.hh"
+#include "portfolio.hh"
+#include "wordfill.hh"
+#include "tools.hh"
+
+typedef std::chrono::steady_clock genclock;
+
+struct Pattern {
+    std::string name;
+    Grid grid;
+};
+
+class Generator {
+public:
+    std::vector<Pattern> patterns;
+    Dict *d;
+    // the words of the word filler
+    WordList *words;
+    std::string filler, walker, backtracker;
+    // threads of the parallel and portfolio fillers
+    int fillthreads;
+    unsigned int seed;
+    long count, maxattempts, msecs;
+    bool nodupes, scored;
+
+    std::atomic<long> attempts, failures, errors;
+    long written;
+    // with -stats, the statistics of every attempt by id
+    bool withstats;
+    std::map<long, std::string> stats;
+
+    Generator(std::ostream &theout)
+        : d(0), words(0), filler("cell"), fillthreads(1), seed(1), count(100), maxattempts(0), msecs(10000), nodupes(false), scored(false),
+          attempts(0), failures(0), errors(0), written(0), withstats(false), out(theout), nextid(0) {}
+    void run();
+
+private:
+    std::ostream &out;
+    std::mutex outlock;
+    // finished attempts from nextid on, "" for failures
+    std::map<long, std::string> pending;
+    long nextid;
+
+    bool done();
+    void finish(long n, const std::string &line);
+    std::string fill(long n);
+    void report(long n, const std::string &msg);
+    bool fillcells(Grid &g, long n, long &nodes);
+    bool fillparallel(Grid &g, long n);
+    bool fillportfolio(Grid &g, long n);
+    bool fillwords(Grid &g, long n, long &nodes);
+};
+
+bool Generator::done() {
+    std::lock_guard<std::mutex> l(outlock);
+    return written >= count;
+}
+
+bool Generator::fillcells(Grid &g, long n, long &nodes) {
+    Walker *w = makewalker(walker, g);
+    Backtracker *bt = makebacktracker(backtracker, g);
+    IterativeCompiler c(g, *w, *bt, *d);
+    c.nodupes = nodupes;
+    c.scored = scored;
+    c.setSeed(seed + n);
+#ifdef CWC_STATS
+    SearchStats st;
+    if (withstats)
+        c.stats = &st;
+#endif
+    bool solved = c.run(0, msecs) == IterativeCompiler::solved;
+    nodes = c.getNodes();
+#ifdef CWC_STATS
+    if (withstats) {
+        std::ostringstream os;
+        os << "{\"id\": " << n << ", \"pattern\": " << jsonquote(patterns[n % patterns.size()].name)
+           << ", \"solved\": " << (solved ? "true" : "false") << ", \"stats\":\n";
+        st.writejson(os);
+        std::string s = os.str();
+        s.erase(s.find_last_not_of('\n') + 1);
+        std::lock_guard<std::mutex> l(outlock);
+        stats[n] = s + "}";
+    }
+#endif
+    delete bt;
+    delete w;
+    return solved;
+}
+
+bool Generator::fillparallel(Grid &g, long n) {
+    ParallelCompiler c(g, *d);
+    c.setThreads(fillthreads);
+    c.setSeed(seed + n);
+    Deadline dl(msecs, [&c] { c.cancel(); });
+    return c.compile();
+}
+
+bool Generator::fillportfolio(Grid &g, long n) {
+    Portfolio c(g, *d);
+    c.setThreads(fillthreads);
+    c.setSeed(seed + n);
+    Deadline dl(msecs, [&c] { c.cancel(); });
+    return c.compile();
+}
+
+bool Generator::fillwords(Grid &g, long n, long &nodes) {
+    WordFiller c(g, *words);
+    c.unique = nodupes;
+    c.setSeed(seed + n);
+    std::atomic<bool> cancelled(false);
+    c.setCancelFlag(&cancelled);
+    Deadline dl(msecs, [&cancelled] { cancelled = true; });
+    bool solved = c.fill();
+    nodes = c.getNodes();
+    return solved;
+}
+
+// attempt n as a JSON line, or "" when it fails
+std::string Generator::fill(long n) {
+    const Pattern &p = patterns[n % patterns.size()];
+    Grid g(p.grid);
+    // -1 for fillers that don't count them
+    long nodes = -1;
+
+    genclock::time_point t = genclock::now();
+    bool solved;
+    if (filler == "parallel")
+        solved = fillparallel(g, n);
+    else if (filler == "portfolio")
+        solved = fillportfolio(g, n);
+    else if (filler == "word")
+        solved = fillwords(g, n, nodes);
+    else
+        solved = fillcells(g, n, nodes);
+    double ms = std::chrono::duration<double, std::milli>(genclock::now() - t).count();
+    if (!solved)
+        return "";
+    std::string bad = checkfill(g, *d, nodupes);
+    if (!bad.empty()) {
+        report(n, "bad fill: " + bad);
+        return "";
+    }
+
+    std::ostringstream os;
+    os << "{\"id\": " << n << ", \"pattern\": " << jsonquote(p.name)
+       << ", \"seed\": " << seed + n << ", \"width\": " << g.w << ", \"height\": " << g.h
+       << ", \"rows\": [";
+    for (int y = 0; y < g.h; y++) {
+        std::string row;
+        for (int x = 0; x < g.w; x++)
+            row += g.cellat(x, y).isoutside() ? '#' : char(g.cellat(x, y).getsymbol());
+        os << (y ? ", " : "") << jsonquote(row);
+    }
+
+    Answers an = g.getanswers();
+    ClueNumbering *dirs[] = { &an.across, &an.down };
+    const char *names[] = { "across", "down" };
+    for (int i = 0; i < 2; i++) {
+        os << "], \"" << names[i] << "\": [";
+        bool first = true;
+        for (std::set<int>::iterator k = dirs[i]->clues.begin(); k != dirs[i]->clues.end(); k++) {
+            os << (first ? "" : ", ") << '[' << *k << ", " << jsonquote(dirs[i]->cluetoanswer[*k]) << ']';
+            first = false;
+        }
+    }
+    os << "]";
+    if (nodes >= 0)
+        os << ", \"nodes\": " << nodes;
+    os << ", \"msecs\": " << ms << "}\n";
+    return os.str();
+}
+
+void Generator::report(long n, const std::string &msg) {
+    std::lock_guard<std::mutex> l(outlock);
+    std::cerr << "attempt " << n << " (" << patterns[n % patterns.size()].name << "): "
+              << msg << std::endl;
+    errors++;
+}
+
+// writes the attempts that are next in id order
+void Generator::finish(long n, const std::string &line) {
+    std::lock_guard<std::mutex> l(outlock);
+    pending[n] = line;
+    std::map<long, std::string>::iterator i;
+    while ((i = pending.find(nextid)) != pending.end()) {
+        if (!i->second.empty() && written < count) {
+            out << i->second;
+            written++;
+        }
+        pending.erase(i);
+        nextid++;
+    }
+}
+
+void Generator::run() {
+    while (!done()) {
+        long n = attempts.fetch_add(1);
+        if (n >= maxattempts)
+            return;
+        std::string line;
+        try {
+            line = fill(n);
+        } catch (error &e) {
+            report(n, e.what());
+        }
+        if (line.empty())
+            failures++;
+        finish(n, line);
+    }
+}
+
+static void usage(const char *name) {
+    std::cerr << "usage: " << name << " [options] <wordlist> <pattern or directory>..." << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    std::string dictname = "bitmap", indexfile, outfile, tracefile, statsfile;
+    std::string filler = "cell", walker = "flood", backtracker = "conflict";
+    long count = 100, attempts = -1, msecs = 10000;
+    unsigned int seed = 1;
+    int threads = 0, minscore = INT_MIN;
+    bool nodupes = false, scored = false;
+
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a[0] != '-') {
+            args.push_back(a);
+            continue;
+        }
+        if (a == "-nodupes") {
+            nodupes = true;
+            continue;
+        }
+        if (a == "-scored") {
+            scored = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            usage(argv[0]);
+        std::string v = argv[++i];
+        if (a == "-count") count = atol(v.c_str());
+        else if (a == "-threads") threads = atoi(v.c_str());
+        else if (a == "-filler") filler = v;
+        else if (a == "-dict") dictname = v;
+        else if (a == "-index") indexfile = v;
+        else if (a == "-walker") walker = v;
+        else if (a == "-backtracker") backtracker = v;
+        else if (a == "-seed") seed = strtoul(v.c_str(), 0, 10);
+        else if (a == "-msecs") msecs = atol(v.c_str());
+        else if (a == "-attempts") attempts = atol(v.c_str());
+        else if (a == "-minscore") minscore = atoi(v.c_str());
+        else if (a == "-o") outfile = v;
+        else if (a == "-trace") tracefile = v;
+#ifdef CWC_STATS
+        else if (a == "-stats") statsfile = v;
+#else
+        else if (a == "-stats") {
+            std::cerr << "-stats needs a build with -DCWC_STATS" << std::endl;
+            return EXIT_FAILURE;
+        }
+#endif
+        else usage(argv[0]);
+    }
+    if (args.size() < 2 || count < 1)
+        usage(argv[0]);
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::ofstream file;
+    if (!outfile.empty()) {
+        file.open(outfile.c_str());
+        if (!file.is_open()) {
+            std::cerr << "Failed to create " << outfile << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    // the dictionaries and grids talk on stdout, keep it for the puzzles
+    std::ostream out(outfile.empty() ? std::cout.rdbuf() : file.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    Symbol::buildindex();
+    std::vector<Dict*> owned;
+    int status = EXIT_SUCCESS;
+    try {
+        Generator gen(out);
+        gen.d = makedict(dictname, args[0], indexfile, owned, minscore);
+        gen.filler = filler;
+        gen.walker = walker;
+        gen.backtracker = backtracker;
+        gen.seed = seed;
+        gen.count = count;
+        gen.maxattempts = attempts < 0 ? 4 * count + 100 : attempts;
+        gen.msecs = msecs;
+        gen.nodupes = nodupes;
+        gen.scored = scored;
+
+        // fail early on bad names
+        if (filler != "cell" && filler != "parallel" && filler != "portfolio" &&
+            filler != "word")
+            throw error("Unknown filler " + filler);
+        if (scored && filler != "cell")
+            throw error("-scored needs the cell filler");
+        if (nodupes && filler != "cell" && filler != "word")
+            throw error("-nodupes needs the cell or word filler");
+        if (!statsfile.empty() && filler != "cell")
+            throw error("-stats needs the cell filler");
+        gen.withstats = !statsfile.empty();
+        Grid probe;
+        delete makewalker(walker, probe);
+        delete makebacktracker(backtracker, probe);
+
+        WordList words;
+        if (filler == "word") {
+            words.minscore = minscore;
+            words.load(args[0]);
+            gen.words = &words;
+        }
+
+        std::vector<std::string> files;
+        for (size_t i = 1; i < args.size(); i++)
+            addpatterns(args[i], files);
+        for (size_t i = 0; i < files.size(); i++) {
+            Pattern p;
+            p.name = patternname(files[i]);
+            try {
+                if (loadpattern(files[i], p.grid))
+                    gen.patterns.push_back(p);
+            } catch (error &e) {
+                std::cerr << "skipping " << files[i] << ": " << e.what() << std::endl;
+            }
+        }
+        if (gen.patterns.empty())
+            throw error("No grid templates given");
+
+        // these fillers take all threads for one attempt
+        int runners = threads;
+        if (filler == "parallel" || filler == "portfolio") {
+            gen.fillthreads = threads;
+            runners = 1;
+        }
+
+        genclock::time_point t = genclock::now();
+        std::vector<std::thread> pool;
+        for (int i = 0; i < runners; i++)
+            pool.push_back(std::thread(&Generator::run, &gen));
+        for (size_t i = 0; i < pool.size(); i++)
+            pool[i].join();
+        out.flush();
+        double secs = std::chrono::duration<double>(genclock::now() - t).count();
+
+        long tried = std::min(gen.attempts.load(), gen.maxattempts);
+        std::cerr << gen.written << " puzzles from " << gen.patterns.size() << " patterns in "
+                  << secs << " s on " << threads << " threads, "
+                  << (secs > 0 ? gen.written / secs : 0) << " puzzles/s, "
+                  << gen.failures << " of " << tried << " attempts failed" << std::endl;
+        if (!statsfile.empty()) {
+            std::ofstream f(statsfile.c_str());
+            if (!f.is_open())
+                throw error("Failed to create " + statsfile);
+            f << "[";
+            for (std::map<long, std::string>::iterator i = gen.stats.begin(); i != gen.stats.end(); i++)
+                f << (i == gen.stats.begin() ? "\n" : ",\n") << i->second;
+            f << "\n]" << std::endl;
+        }
+
+        if (gen.errors > 0)
+            throw error(std::to_string(gen.errors.load()) + " attempts went wrong");
+        if (gen.written < count)
+            throw error("Too many failed attempts");
+    } catch (error &e) {
+        std::cerr << e.what() << std::endl;
+        status = EXIT_FAILURE;
+    }
+    // failed runs too, they are what the traces are for
+    if (!tracefile.empty())
+        dumptrace(tracefile);
+    for (size_t i = owned.size(); i-- > 0; )
+        delete owned[i];
+    return status;
+}
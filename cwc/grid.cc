@@ -21,74 +21,67 @@
 
 #include <fstream>
 #include <stdio.h>
+#include <limits.h>
 #include <sstream>
 #include <algorithm>
+#include <mutex>
 
 #include "grid.hh"
-
-//////////////////////////////////////////////////////////////////////
-// wordblock
-
-WordBlock::WordBlock() {
-    cls_size = 0;
-}
-
-void WordBlock::getword(Symbol *s) {
-    int i, len = cls.size();
-    for (i = 0; i < len; i++)
-        s[i] = cls[i]->getsymbol();
-}
+#include "gridkernel.hh"
 
 //////////////////////////////////////////////////////////////////////
 // class cell
 
-Cell Cell::outside_cell;
-
-Cell::Cell(Symbol s) :
-    wbl_size(0), attempts(0), symb(s), preferred(Symbol::none), locked(false) {
-}
-
-void Cell::addword(WordBlock *w, int pos) {
-    struct WordRef wr = {pos, w};
-    wbl.push_back(wr);
-    wbl_size++;
-}
-
 void Cell::setsymbol(const Symbol &s) {
-    if (locked)
+    if (n < 0)
+        return;
+    if (g->locked[n])
         throw error("Attempt to set symbol in locked cell");
     if (!(s == Symbol::empty) && !(s == Symbol::outside))
-        attempts++;
-    symb = s;
+        g->attempts[n]++;
+    if (s == g->symbols[n])
+        return;
+    g->symbols[n] = s;
+    invalidatecrossing();
+}
+
+// the answer cached for a word only depends on the cells of that word,
+// so a change only affects the cells sharing a word with this one.
+void Cell::invalidatecrossing() {
+    for (int e = g->cellstart[n]; e < g->cellstart[n+1]; e++)
+        g->invalidateslot(g->cellslots[e]);
 }
 
 void Cell::remove() {
-    symb = Symbol::outside;
+    if (n < 0)
+        return;
+    g->symbols[n] = Symbol::outside;
+    invalidatecrossing();
 }
 
 void Cell::clear(bool setpreferred) {
-    if (setpreferred)
-        preferred = symb;
-    else
-        preferred = Symbol::none;
+    if (n < 0)
+        return;
+    Symbol &symb = g->symbols[n];
+    g->preferred[n] = setpreferred ? symb : Symbol::none;
+    if (symb == Symbol::empty)
+        return;
     symb = Symbol::empty;
+    invalidatecrossing();
 }
 
-std::ostream &operator << (std::ostream &os, Cell &c) {
-    return os << c.symb;
-}
-
-bool Cell::isoutside() {
-    return symb == Symbol::outside;
+std::ostream &operator << (std::ostream &os, Cell c) {
+    return os << c.getsymbol();
 }
 
 bool Cell::isfilled() {
+    Symbol symb = getsymbol();
     return (symb!=Symbol::empty)&&(symb!=Symbol::outside);
 }
 
 std::string Cell::tostring() {
     std::ostringstream s;
-    s << symb;
+    s << getsymbol();
     return s.str();
 }
 
@@ -112,20 +105,115 @@ std::ostream &operator << (std::ostream &os, Coord &c) {
 // class grid
 
 Grid::Grid(int width, int height)
-    : cls(0), cls_size(0), verbose(false) {
+    : ncells(0), domaindict(0), verbose(false), stats(0) {
     init_grid(width, height);
-    cellno(-1).setsymbol(Symbol::outside);
     buildwords();
 }
 
+/**
+ * copies are plain copies of the cell and slot arrays, the search state
+ * included; the kernel and the pattern statistics only depend on the
+ * pattern and are shared. This allows several compilers to work on
+ * private copies of the same pattern.
+ */
+
+Grid::Grid(const Grid &other)
+    : symbols(other.symbols), preferred(other.preferred), locked(other.locked),
+      attempts(other.attempts), ncells(other.ncells),
+      slotstart(other.slotstart), slotcells(other.slotcells),
+      slotentries(other.slotentries), cellstart(other.cellstart),
+      cellslots(other.cellslots), cellslotpos(other.cellslotpos),
+      domains(other.domains), domainvalid(other.domainvalid),
+      domaindict(other.domaindict), used(other.used), slotword(other.slotword),
+      trail(other.trail), kernel(other.kernel), shape(other.shape),
+      verbose(other.verbose), stats(0), w(other.w), h(other.h) {
+}
+
+Grid &Grid::operator=(const Grid &other) {
+    if (this == &other)
+        return *this;
+    symbols = other.symbols;
+    preferred = other.preferred;
+    locked = other.locked;
+    attempts = other.attempts;
+    ncells = other.ncells;
+    slotstart = other.slotstart;
+    slotcells = other.slotcells;
+    slotentries = other.slotentries;
+    cellstart = other.cellstart;
+    cellslots = other.cellslots;
+    cellslotpos = other.cellslotpos;
+    domains = other.domains;
+    domainvalid = other.domainvalid;
+    domaindict = other.domaindict;
+    used = other.used;
+    slotword = other.slotword;
+    trail = other.trail;
+    kernel = other.kernel;
+    shape = other.shape;
+    verbose = other.verbose;
+    w = other.w;
+    h = other.h;
+    return *this;
+}
+
+Grid::~Grid() {
+}
+
+/**
+ * numbers the slots in the order given and lays them out in the flat
+ * tables. The words of every cell come in increasing slot order.
+ */
+
+void Grid::buildtables(const std::vector<std::vector<int> > &slots) {
+    int nslots = slots.size();
+    slotstart.assign(1, 0);
+    slotcells.clear();
+    std::vector<int> count(ncells + 1, 0);
+    for (int s = 0; s < nslots; s++) {
+        for (size_t pos = 0; pos < slots[s].size(); pos++) {
+            slotcells.push_back(slots[s][pos]);
+            count[slots[s][pos] + 1]++;
+        }
+        slotstart.push_back(slotcells.size());
+    }
+
+    cellstart.assign(count.begin(), count.end());
+    for (int c = 0; c < ncells; c++)
+        cellstart[c+1] += cellstart[c];
+    cellslots.assign(slotcells.size(), 0);
+    cellslotpos.assign(slotcells.size(), 0);
+    slotentries.assign(slotcells.size(), 0);
+    std::vector<int> next(cellstart.begin(), cellstart.end() - 1);
+    for (int s = 0; s < nslots; s++) {
+        for (int k = slotstart[s]; k < slotstart[s+1]; k++) {
+            int e = next[slotcells[k]]++;
+            cellslots[e] = s;
+            cellslotpos[e] = k - slotstart[s];
+            slotentries[k] = e;
+        }
+    }
+
+    domains.assign(cellslots.size(), 0);
+    domainvalid.assign(cellslots.size(), 0);
+    domaindict = 0;
+    trail.clear();
+    used.clear();
+    slotword.assign(nslots, -1);
+    kernel.reset();
+    shape = std::make_shared<GridShape>();
+}
+
 void Grid::init_grid(int w, int h) {
     this->w = w;
     this->h = h;
-    cls.clear();
-    for (int i = 0; i < w*h; i++) {
-        cls.push_back(Cell());
-    }
-    cls_size = cls.size();
+    ncells = w*h;
+    symbols.assign(ncells, Symbol::empty);
+    preferred.assign(ncells, Symbol::none);
+    locked.assign(ncells, 0);
+    attempts.assign(ncells, 0);
+    // no words until buildwords()
+    buildtables(std::vector<std::vector<int> >());
 }
 
 /**
@@ -157,26 +245,53 @@ void grid::get_template_v(const coord &c, symbol *s, int &len, int &pos) {
 **/
 
 SymbolSet Cell::findpossible(Dict &d) {
-    int nwords = numwords();
-    if (nwords == 0) throw error("Bugger");
+    if (n < 0 || g->cellstart[n] == g->cellstart[n+1]) throw error("Bugger");
 
     SymbolSet ss = ~0;
 
-    for (int i = 0; i < nwords; i++) {
-
-        int pos = getpos(i);
-        WordBlock &wb = getwordblock(i);
-        int len = wb.length();
+    for (int e = g->cellstart[n]; e < g->cellstart[n+1]; e++) {
+        int s = g->cellslots[e];
+        int len = g->slotlength(s);
 
         Symbol word[len+1]; word[len] = Symbol::outside;
+        for (int p = 0; p < len; p++)
+            word[p] = g->symbols[g->slotcell(s, p)];
+
+        ss &= d.findpossible(word, len, g->cellslotpos[e]); // intersect solutions
+    }
+
+    return ss;
+}
 
-        wb.getword(word);
+SymbolSet Grid::findpossible(int cno, Dict &d) {
+    if (kernel)
+        return kernel->findpossible(*this, cno, d);
 
-        ss &= d.findpossible(word, len, pos); // intersect solutions
-//        if (setup.verbose) {
-//            cout << "vertical: "; dumpsymbollist(word, len);
-//            dumpset(ss);
-//        }
+    int first = cellstart[cno], last = cellstart[cno+1];
+    if (first == last) throw error("Bugger");
+
+    if (domaindict != &d) {
+        domainvalid.assign(domainvalid.size(), 0);
+        domaindict = &d;
+    }
+
+    SymbolSet ss = ~0;
+
+    for (int e = first; e < last; e++) {
+        if (!domainvalid[e]) {
+            int start = slotstart[cellslots[e]];
+            int len = slotstart[cellslots[e] + 1] - start;
+
+            Symbol word[len+1]; word[len] = Symbol::outside;
+            for (int p = 0; p < len; p++)
+                word[p] = symbols[slotcells[start + p]];
+
+            CWC_COUNT(stats, query(d));
+            domains[e] = d.findpossible(word, len, cellslotpos[e]);
+            domainvalid[e] = 1;
+        } else
+            CWC_COUNT(stats, domainhit());
+        ss &= domains[e]; // intersect solutions
     }
 
     return ss;
@@ -209,9 +324,9 @@ void Grid::load_template(std::istream &tf) {
             else if (ch == ' ' ) {
                 cellat(x, y).remove();
             }
-            else if (isalpha(ch)) {
+            else if (Symbol::isletter(ch)) {
                 std::cout << "character: "  << ch << std::endl;
-                cellat(x, y).setsymbol(tolower(ch));
+                cellat(x, y).setsymbol(tolower((unsigned char)ch));
             }
             else
                 throw error("Invalid character in input file");
@@ -230,83 +345,84 @@ void Grid::load(const std::string &fn) {
 
 void Grid::load(std::istream &f)
 {
-    cls.clear();
-    wbl.clear();
+    symbols.clear();
+    preferred.clear();
+    locked.clear();
+    attempts.clear();
+    ncells = 0;
+    kernel.reset();
     w = h = 0;
+    std::vector<std::vector<int> > slots;
     std::string ln;
 
     while (!f.eof()) {
         std::getline(f, ln);
         const char *st = ln.c_str();
 
-        WordBlock *wb = new WordBlock();
-        int pos = 0;
+        std::vector<int> slot;
         while (*st != '\0') {
             while (*st&&(!isdigit(*st))) st++;
             if (*st == '\0') break;
             int a = atoi(st);
-            while (cls.size() <= unsigned(a))
-                cls.push_back(Cell(Symbol::outside));
-            cls_size = cls.size();
-            cls[a].setsymbol(Symbol::empty);
-            wb->addcell(a, *this);
-            cls[a].addword(wb, pos); pos++;
+            if (ncells <= a) {
+                ncells = a + 1;
+                symbols.resize(ncells, Symbol::outside);
+                preferred.resize(ncells, Symbol::none);
+                locked.resize(ncells, 0);
+                attempts.resize(ncells, 0);
+            }
+            symbols[a] = Symbol::empty;
+            slot.push_back(a);
             while (*st && (isdigit(*st))) st++;
         }
-        if (wb->length())
-            wbl.push_back(wb);
-        else
-            delete wb;
+        if (!slot.empty())
+            slots.push_back(slot);
     }
+    buildtables(slots);
     lock();
 
 }
 
 /**
- * builds the words/cell structures when we use a square grid formation
+ * builds the slot tables when we use a square grid formation
  */
 
 void Grid::buildwords() {
-    wbl.clear();
-    for (int n = 0; n < numcells(); n++)
-        cls[n].clearwords();
+    std::vector<std::vector<int> > slots;
 
     for (int y = 0; y < h; y++) {
         for (int x = 0; x < w; x++) {
-            int cno = cellnofromxy(x, y);
-            WordBlock *w = 0;
-            int pos = 0;
+            std::vector<int> slot;
             while (cellat(x, y).isinside()) {
-                if (w==0) { w = new WordBlock(); wbl.push_back(w); }
-                w->addcell(cno, *this);
-                cellno(cno).addword(w, pos);
-                pos++;
+                slot.push_back(cellnofromxy(x, y));
                 x++;
-                cno = cellnofromxy(x, y);
             }
+            if (!slot.empty())
+                slots.push_back(slot);
         }
     }
     for (int x = 0; x < w; x++) {
         for (int y = 0; y < h; y++) {
-            WordBlock *w = 0;
-            int pos = 0;
+            std::vector<int> slot;
             while (cellat(x, y).isinside()) {
-                if (w == 0) { w = new WordBlock(); wbl.push_back(w); }
-                w->addcell(cellnofromxy(x, y), *this);
-                cellat(x, y).addword(w, pos);
-                pos++; y++;
+                slot.push_back(cellnofromxy(x, y));
+                y++;
             }
+            if (!slot.empty())
+                slots.push_back(slot);
         }
     }
+    buildtables(slots);
+    kernel.reset(GridKernel::create(*this));
 }
 
 void Grid::dump_ggrid(std::ostream &os) {
     bool first = true;
-    for (std::vector<WordBlock*>::iterator i = wbl.begin(); i != wbl.end(); i++) {
-        int wlen = (*i)->length();
+    for (int s = 0; s < numslots(); s++) {
+        int wlen = slotlength(s);
         for (int p = 0; p < wlen; p++) {
             if (!first) std::cout << ' ';
-            os << (*i)->getcellno(p);
+            os << slotcell(s, p);
             first = false;
         }
         os << std::endl; first = true;
@@ -329,7 +445,7 @@ void Grid::dump_ascii(std::ostream &os,Answers * an) {
         if (an) {
             os << "|";
             for (int x=0; x<w; x++) {
-                Cell &c = cellat(x,y);
+                Cell c = cellat(x,y);
                 if (c.isoutside())
                     os << "XXX|";
                 else {
@@ -349,7 +465,7 @@ void Grid::dump_ascii(std::ostream &os,Answers * an) {
         // Now draw the rows with the letters:
         os << "|";
         for (int x=0; x<w; x++) {
-            Cell &c = cellat(x,y);
+            Cell c = cellat(x,y);
             if (c.isoutside())
                 os << "XXX|";
             else
@@ -362,18 +478,18 @@ void Grid::dump_ascii(std::ostream &os,Answers * an) {
 
 void Grid::dump(std::ostream &os, Answers * an) {
     if (w == 0) {
-        for (int i = 0; unsigned(i) < wbl.size(); i++) {
-            int len = wbl[i]->length();
+        for (int i = 0; i < numslots(); i++) {
+            int len = slotlength(i);
             Symbol *s = new Symbol[len + 1];
             s[len] = Symbol::outside;
-            wbl[i]->getword(s);
+            getword(i, s);
             os << s << ' ';
             delete[] s;
 
             os << '(';
             for (int p = 0; p < len; p++) {
                 if (p) os << ',';
-                os << wbl[i]->getcellno(p);
+                os << slotcell(i, p);
             }
             os << ')' << std::endl;
         }
@@ -388,22 +504,18 @@ Answers Grid::getanswers() {
     std::set<int> startcells;
     /* Index the start cells, and decide which are across and down
        clues: */
-    std::vector<WordBlock*>::iterator i;
-    for (i=wbl.begin();
-         i!=wbl.end();
-         ++i) {
-        WordBlock * wb = *i;
-        int l=wb->length();
+    for (int i = 0; i < numslots(); i++) {
+        int l=slotlength(i);
         if (l>1) {
             // Then it's a real clue. Guess if it's across or down:
-            int firstcell=wb->getcellno(0);
-            int secondcell=wb->getcellno(1);
+            int firstcell=slotcell(i, 0);
+            int secondcell=slotcell(i, 1);
             bool across = (firstcell + 1) == secondcell;
             // Get the answer as a string:
             char * c_str=new char[l+1];
             Symbol *symbols = new Symbol[l+1];
             symbols[l] = Symbol::outside;
-            wb->getword(symbols);
+            getword(i, symbols);
             for(int k=0;k<l;++k) {
                 c_str[k] = (char)symbols[k];
             }
@@ -442,22 +554,6 @@ Answers Grid::getanswers() {
     return c;
 }
 
-float Grid::interlockdegree() {
-    int interlocked = 0, total = 0;
-    for (int y=0; y<h; y++) {
-        for (int x=0;x<w;x++) {
-            if (cellat(x, y).isinside()) {
-                bool vertuse = cellat(x, y-1).isinside() || cellat(x, y+1).isinside();
-                bool horizuse = cellat(x-1, y).isinside() || cellat(x+1, y).isinside();
-                if (vertuse && horizuse)
-                    interlocked++;
-                total++;
-            }
-        }
-    }
-    return float(interlocked) / float(total);
-}
-
 float Grid::attemptaverage() {
     int sum = 0, n = 0;
     for (int y=0; y<h; y++) {
@@ -471,38 +567,376 @@ float Grid::attemptaverage() {
     return sum / float(n);
 }
 
-double Grid::dependencydegree(int level) {
-    int n = numcells(), ncell = 0;
-    int d = 0;
-    for (int i = 0; i < n; i++) {
-        if (cellno(i).isinside()) {
-            d += celldependencies(i, level);
-            ncell++;
+//////////////////////////////////////////////////////////////////////
+// pattern statistics
+//
+// Two cells depend on each other when they share a word. The dependency
+// graph is kept as a bitset row per cell, and the cells within k steps
+// of every cell are found by one breadth first search over all cells at
+// once: a pass ors the rows of the cells each one reached last. Levels
+// are added when asked for and kept, so asking again is a lookup, and
+// the search stops once no cell reaches anything new.
+
+class GridShape {
+public:
+    GridShape() : built(false), saturated(false), n(0), rowwords(0),
+                  ninside(0), ninterlocked(0) {}
+
+    std::mutex lock;
+    bool built, saturated;
+    int n, rowwords;
+    int ninside, ninterlocked;
+    std::vector<char> inside;
+    // n rows of rowwords words each
+    std::vector<uint64_t> adjacent, reached, last;
+    // reach[k][c]: cells within k steps of c
+    std::vector<std::vector<int> > reach;
+    std::vector<double> degree;
+    std::vector<int> order;
+
+    void build(Grid &g);
+    const std::vector<int> &level(int k);
+
+private:
+    uint64_t *row(std::vector<uint64_t> &v, int c) { return &v[size_t(c) * rowwords]; }
+    void extend();
+};
+
+void GridShape::build(Grid &g) {
+    if (built)
+        return;
+    built = true;
+    n = g.numcells();
+    rowwords = (n + 63) / 64;
+
+    inside.assign(n, 0);
+    for (int c = 0; c < n; c++) {
+        if (!g.cellno(c).isinside())
+            continue;
+        inside[c] = 1;
+        ninside++;
+        int nlong = 0;
+        for (int i = 0; i < g.numcellslots(c); i++)
+            if (g.slotlength(g.cellslot(c, i)) > 1)
+                nlong++;
+        if (nlong >= 2)
+            ninterlocked++;
+    }
+
+    adjacent.assign(size_t(n) * rowwords, 0);
+    for (int s = 0; s < g.numslots(); s++) {
+        int len = g.slotlength(s);
+        for (int i = 0; i < len; i++) {
+            uint64_t *r = row(adjacent, g.slotcell(s, i));
+            for (int j = 0; j < len; j++) {
+                int other = g.slotcell(s, j);
+                r[other / 64] |= uint64_t(1) << (other % 64);
+            }
+        }
+    }
+
+    // level 0: every cell reaches itself
+    reached.assign(size_t(n) * rowwords, 0);
+    for (int c = 0; c < n; c++)
+        row(reached, c)[c / 64] |= uint64_t(1) << (c % 64);
+    last = reached;
+    reach.assign(1, std::vector<int>(n, 1));
+}
+
+void GridShape::extend() {
+    std::vector<uint64_t> next(size_t(n) * rowwords, 0);
+    std::vector<int> count(n);
+    bool grew = false;
+    for (int c = 0; c < n; c++) {
+        uint64_t *nx = row(next, c), *r = row(reached, c), *l = row(last, c);
+        for (int k = 0; k < rowwords; k++) {
+            for (uint64_t m = l[k]; m; m &= m - 1) {
+                const uint64_t *a = row(adjacent, k * 64 + firstbit(m));
+                for (int j = 0; j < rowwords; j++)
+                    nx[j] |= a[j];
+            }
         }
+        int total = 0;
+        for (int k = 0; k < rowwords; k++) {
+            nx[k] &= ~r[k];
+            r[k] |= nx[k];
+            if (nx[k])
+                grew = true;
+            total += popcount(r[k]);
+        }
+        count[c] = total;
     }
-    return double(d) / double(ncell);
+    last.swap(next);
+    reach.push_back(count);
+    saturated = !grew;
+}
+
+// past the level where the search ran out, every level is the same
+const std::vector<int> &GridShape::level(int k) {
+    if (k < 0)
+        k = 0;
+    while (int(reach.size()) <= k && !saturated)
+        extend();
+    return reach[std::min(k, int(reach.size()) - 1)];
+}
+
+float Grid::interlockdegree() {
+    std::lock_guard<std::mutex> l(shape->lock);
+    shape->build(*this);
+    return float(shape->ninterlocked) / float(shape->ninside);
+}
+
+float Grid::density() {
+    std::lock_guard<std::mutex> l(shape->lock);
+    shape->build(*this);
+    return float(shape->ninside) / float(shape->n);
+}
+
+double Grid::dependencydegree(int level) {
+    std::lock_guard<std::mutex> l(shape->lock);
+    shape->build(*this);
+    std::vector<double> &degree = shape->degree;
+    if (int(degree.size()) <= level)
+        degree.resize(level + 1, -1);
+    if (degree[level] < 0) {
+        const std::vector<int> &reach = shape->level(level);
+        long d = 0;
+        for (int i = 0; i < shape->n; i++)
+            if (shape->inside[i])
+                d += reach[i];
+        degree[level] = double(d) / double(shape->ninside);
+    }
+    return degree[level];
 }
 
 int Grid::celldependencies(int cno, int level) {
-    std::unordered_set<int> cnums;
-    cnums.insert(cno);
-
-    while (level--) {
-        std::unordered_set<int> newnums;
-        for (std::unordered_set<int>::iterator i = cnums.begin(); i != cnums.end(); i++) {
-            int clno = *i;
-            int words = cellno(clno).numwords();
-            for (int w = 0; w < words; w++) {
-                WordBlock &wb = cellno(clno).getwordblock(w);
-                int wlen = wb.length();
-                for (int j = 0; j < wlen; j++)
-                    newnums.insert(wb.getcellno(j));
-            }
+    std::lock_guard<std::mutex> l(shape->lock);
+    shape->build(*this);
+    return shape->level(level)[cno];
+}
+
+const std::vector<int> &Grid::dependencyorder() {
+    std::lock_guard<std::mutex> l(shape->lock);
+    shape->build(*this);
+    std::vector<int> &order = shape->order;
+    if (order.empty() && shape->ninside > 0) {
+        // level 2 first, asking for it may add to the levels
+        const std::vector<int> &two = shape->level(2);
+        const std::vector<int> &one = shape->level(1);
+        for (int c = 0; c < shape->n; c++)
+            if (shape->inside[c])
+                order.push_back(c);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return two[a] != two[b] ? two[a] > two[b] : one[a] > one[b];
+        });
+    }
+    return order;
+}
+
+//////////////////////////////////////////////////////////////////////
+// trail
+//
+// Domains are logged when thrown away, not when computed. An answer
+// computed after the mark is only kept by a rollback if no cell of its
+// word changed before it was computed: undoing a symbol drops the
+// answers of its words, and the older entries then bring back what was
+// valid at that point.
+
+void Grid::logdomain(int e) {
+    Change ch;
+    ch.kind = Change::domainchange;
+    ch.index = e;
+    ch.possible = domains[e];
+    ch.valid = domainvalid[e];
+    trail.push_back(ch);
+}
+
+void Grid::invalidateslot(int s) {
+    for (int k = slotstart[s]; k < slotstart[s+1]; k++) {
+        int e = slotentries[k];
+        if (!domainvalid[e])
+            continue;
+        logdomain(e);
+        domainvalid[e] = 0;
+    }
+}
+
+// a symbol is logged after the domains it throws away, so that undoing
+// it drops the answers computed since before those come back.
+void Grid::setsymbol(int cno, Symbol s) {
+    Change ch;
+    ch.kind = Change::symbolchange;
+    ch.index = cno;
+    ch.symb = symbols[cno];
+    cellno(cno).setsymbol(s);
+    if (!(ch.symb == s))
+        trail.push_back(ch);
+}
+
+void Grid::clear(int cno, bool setpreferred) {
+    Change ch;
+    ch.kind = Change::preferredchange;
+    ch.index = cno;
+    ch.symb = preferred[cno];
+    trail.push_back(ch);
+    ch.kind = Change::symbolchange;
+    ch.symb = symbols[cno];
+    cellno(cno).clear(setpreferred);
+    if (!(ch.symb == Symbol::empty))
+        trail.push_back(ch);
+}
+
+void Grid::rollback(size_t mark, bool undopreferred) {
+    while (trail.size() > mark) {
+        Change &ch = trail.back();
+        switch (ch.kind) {
+        case Change::symbolchange:
+            symbols[ch.index] = ch.symb;
+            dropdomains(ch.index);
+            break;
+        case Change::preferredchange:
+            if (undopreferred)
+                preferred[ch.index] = ch.symb;
+            break;
+        case Change::domainchange:
+            domains[ch.index] = ch.possible;
+            domainvalid[ch.index] = ch.valid;
+            break;
+        case Change::wordclaim:
+            used.reset(slotword[ch.index]);
+            slotword[ch.index] = -1;
+            break;
+        }
+        trail.pop_back();
+    }
+}
+
+// unlogged, for undoing
+void Grid::dropdomains(int cno) {
+    for (int e = cellstart[cno]; e < cellstart[cno+1]; e++) {
+        int s = cellslots[e];
+        for (int k = slotstart[s]; k < slotstart[s+1]; k++)
+            domainvalid[slotentries[k]] = 0;
+    }
+}
+
+void Grid::resetdomains() {
+    domainvalid.assign(domainvalid.size(), 0);
+    trail.clear();
+}
+
+Grid::Snapshot Grid::snapshot() {
+    Snapshot s;
+    s.symbols = symbols;
+    s.preferred = preferred;
+    s.locked = locked;
+    return s;
+}
+
+void Grid::restore(const Snapshot &s) {
+    if (s.symbols.size() != size_t(ncells))
+        throw error("Snapshot is for another grid");
+    symbols = s.symbols;
+    preferred = s.preferred;
+    locked = s.locked;
+    resetdomains();
+    used.clear();
+    slotword.assign(slotword.size(), -1);
+}
+
+//////////////////////////////////////////////////////////////////////
+// word claims
+//
+// Only slots of two or more cells are words. Words the dictionary has
+// no id for can't be told apart and are never claimed.
+
+bool Grid::claimwords(int cno, Dict &d) {
+    for (int e = cellstart[cno]; e < cellstart[cno+1]; e++) {
+        int s = cellslots[e];
+        int start = slotstart[s], len = slotstart[s+1] - start;
+        if (len < 2 || slotword[s] >= 0)
+            continue;
+
+        Symbol word[len+1]; word[len] = Symbol::outside;
+        bool complete = true;
+        for (int p = 0; p < len && complete; p++) {
+            word[p] = symbols[slotcells[start + p]];
+            complete = cellno(slotcells[start + p]).isfilled();
         }
-        for (std::unordered_set<int>::iterator i = newnums.begin(); i != newnums.end(); i++)
-            cnums.insert(*i);
+        if (!complete)
+            continue;
+
+        int id = d.wordid(word, len);
+        if (id < 0)
+            continue;
+        if (used.test(id))
+            return false;
+        used.set(id);
+        slotword[s] = id;
+        Change ch;
+        ch.kind = Change::wordclaim;
+        ch.index = s;
+        trail.push_back(ch);
     }
-    return cnums.size();
+    return true;
+}
+
+bool Grid::claimall(Dict &d) {
+    used.clear();
+    slotword.assign(slotword.size(), -1);
+    bool ok = true;
+    int nslots = numslots();
+    for (int s = 0; s < nslots; s++) {
+        if (slotstart[s+1] - slotstart[s] >= 2 && !claimwords(slotcells[slotstart[s]], d))
+            ok = false;
+    }
+    return ok;
+}
+
+SymbolSet Grid::scoreletters(int cno, Dict &d, int *score) {
+    SymbolSet ss = ~0;
+    for (int i = 0; i < MAXSYMBOLS; i++)
+        score[i] = INT_MAX;
+    for (int e = cellstart[cno]; e < cellstart[cno+1]; e++) {
+        int start = slotstart[cellslots[e]];
+        int len = slotstart[cellslots[e] + 1] - start;
+
+        Symbol word[len+1]; word[len] = Symbol::outside;
+        for (int p = 0; p < len; p++)
+            word[p] = symbols[slotcells[start + p]];
+
+        CWC_COUNT(stats, query(d));
+        int best[MAXSYMBOLS];
+        SymbolSet s = d.findscored(word, len, cellslotpos[e], best);
+        for (SymbolSet m = s; m; m &= m - 1)
+            score[firstbit(m)] = std::min(score[firstbit(m)], best[firstbit(m)]);
+        ss &= s;
+    }
+    return ss;
+}
+
+// only a slot that cno completes can clash, so only those are asked
+SymbolSet Grid::findunused(int cno, Dict &d) {
+    SymbolSet ss = ~0;
+    for (int e = cellstart[cno]; e < cellstart[cno+1]; e++) {
+        int s = cellslots[e];
+        int start = slotstart[s], len = slotstart[s+1] - start;
+        if (len < 2)
+            continue;
+
+        Symbol word[len+1]; word[len] = Symbol::outside;
+        int open = 0;
+        for (int p = 0; p < len; p++) {
+            word[p] = symbols[slotcells[start + p]];
+            if (!cellno(slotcells[start + p]).isfilled())
+                open++;
+        }
+        if (open == 1) {
+            CWC_COUNT(stats, query(d));
+            ss &= d.findunused(word, len, cellslotpos[e], used);
+        }
+    }
+    return ss;
 }
 
 void Grid::lock() {
@@ -514,7 +948,6 @@ void Grid::lock() {
 
 int Grid::getempty() {
     int n = 0;
-    int ncells = numcells();
     for (int i = 0 ; i< ncells; i++)
         if (cellno(i).isempty())
             n++;
@@ -523,9 +956,8 @@ int Grid::getempty() {
 
 int Grid::numopen() {
     int n=0;
-    int ncells = numcells();
     for (int i = 0; i < ncells; i++)
-        if (!cls[i].islocked())
+        if (!locked[i])
             n++;
     return n;
 }
@@ -23,6 +23,7 @@
 #define CWC_GRID_HH
 
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <unordered_map>
 #include <unordered_set>
@@ -30,70 +31,57 @@
 #include <sstream>
 #include "symbol.hh"
 #include "dict.hh"
+#include "stats.hh"
 
 class Cell;
-class WordBlock;
 class Grid;
-struct WordRef {
-    int pos;
-    WordBlock *wbl;
-};
+class GridKernel;
+class GridShape;
+
+/**
+ * A cell of a grid. The grid keeps its cells in flat arrays indexed by
+ * cell number, so that copying a grid copies plain vectors; a Cell is
+ * only a handle to one of them and is passed by value. Cells off the
+ * grid read as outside and ignore changes.
+ */
 
 class Cell {
-    std::vector<WordRef> wbl; int wbl_size;
-    int attempts;
-    Symbol symb;
-    Symbol preferred;
-    bool locked;
+    Grid *g;
+    int n;
+    friend class Grid;
+    void invalidatecrossing();
 public:
-    static Cell outside_cell;
+    Cell(Grid *thegrid = 0, int no = -1) : g(thegrid), n(no) {}
 
-    Cell(Symbol s = Symbol::empty); // ctor
+    // changes the symbol without logging it; solvers use Grid::setsymbol()
     void setsymbol(const Symbol &s);
 
-    // structural methods
-    void addword(WordBlock *w, int pos);
-    int numwords() { return wbl_size; }
-    WordBlock &getwordblock(int wordno) { return *wbl[wordno].wbl; }
-    int getpos(int wordno) { return wbl[wordno].pos; }
-    void clearwords() { wbl.clear(); }
-
-    Symbol getsymbol() { return symb; }
-    Symbol getpreferred() { return preferred; }
+    inline Symbol getsymbol();
+    inline Symbol getpreferred();
+    inline void setpreferred(Symbol s);
 
-    bool haspreferred() { return preferred != Symbol::none; }
-    void usepreferred();
+    bool haspreferred() { return getpreferred() != Symbol::none; }
     void remove(); // remove from grid (make outsider)
     void clear(bool setpreferred = true); // make empty
 
-    bool isoutside();
+    bool isoutside() { return getsymbol() == Symbol::outside; }
     bool isinside() { return !isoutside(); }
 
     bool isempty() {
-        return symb == Symbol::empty;
+        return getsymbol() == Symbol::empty;
     }
 
     bool isfilled();
 
-    int getattempts() { return attempts; }
+    inline int getattempts();
 
-    bool islocked() { return locked; }
-    void lock() { locked = true; }
+    inline bool islocked();
+    inline void lock();
 
+    // uncached; solvers use Grid::findpossible()
     SymbolSet findpossible(Dict &d);
 
-    friend std::ostream&operator<<(std::ostream &os, Cell &c);
-
-    void dumpwords() {
-        std::cout << "got " << numwords() << " words." << std::endl;
-    }
-
-    // statistics
-
-    int dependencydegree(int level);
-
-    // Build a mapping from cell numbers to clue numbers:
-    std::unordered_map<int,int> celltoclue();
+    friend std::ostream&operator<<(std::ostream &os, Cell c);
 
     std::string tostring();
     std::string touppercasestring();
@@ -127,38 +115,93 @@ public:
 
 class Grid {
 protected:
-    std::vector<Cell> cls; int cls_size;
-    std::vector<WordBlock*> wbl;
+    // the cells, by cell number
+    std::vector<Symbol> symbols, preferred;
+    std::vector<char> locked;
+    std::vector<int> attempts;
+    int ncells;
+    friend class Cell;
+
+    // flat word structure. Slot s holds the cells
+    // slotcells[slotstart[s]..slotstart[s+1]).
+    // Entry e in cellstart[c]..cellstart[c+1] says cell c is at
+    // position cellslotpos[e] of slot cellslots[e]; slotentries maps
+    // each slotcells index back to its entry.
+    std::vector<int> slotstart, slotcells, slotentries;
+    std::vector<int> cellstart, cellslots, cellslotpos;
+
+    // cached dictionary answer per entry, valid until a cell of the
+    // slot changes
+    std::vector<SymbolSet> domains;
+    std::vector<char> domainvalid;
+    Dict *domaindict;
+
+    // words of complete slots, for fills without duplicates, and the
+    // word claimed by every slot (or -1)
+    UsedWords used;
+    std::vector<int> slotword;
+
+    // old value of a cell symbol, preferred symbol or cached domain,
+    // or a word claimed
+    struct Change {
+        enum { symbolchange, preferredchange, domainchange, wordclaim } kind;
+        int index; // cell, domain entry or slot
+        Symbol symb;
+        SymbolSet possible;
+        bool valid;
+    };
+    // undo log, newest last
+    std::vector<Change> trail;
+    void logdomain(int e);
+    void dropdomains(int cno);
+
+    // shape specific findpossible(), if there is one for this grid.
+    // Shared by copies, it only depends on the pattern.
+    std::shared_ptr<const GridKernel> kernel;
+    friend class GridKernel;
+
+    // pattern statistics, worked out when first asked for and shared
+    // by all copies of the grid
+    std::shared_ptr<GridShape> shape;
+    friend class GridShape;
+
     void init_grid(int w, int h);
+    // lays out the slots, each a list of cell numbers, in the tables
+    void buildtables(const std::vector<std::vector<int> > &slots);
 
 public:
     bool verbose;
+    // where the grid counts its queries, if anywhere. Not copied.
+    SearchStats *stats;
     int w, h;
     Grid(int width = 4, int height = 4);
-
-    inline Cell &cellno(int n) {
-        if ((n < 0)||(n >= cls_size))
-            return Cell::outside_cell;
-        return cls[n];
+    Grid(const Grid &other);
+    Grid &operator=(const Grid &other);
+    ~Grid();
+
+    inline Cell cellno(int n) {
+        if ((n < 0)||(n >= ncells))
+            return Cell();
+        return Cell(this, n);
     }
 
     inline int cellnofromxy(int x, int y) {
         return y*w + x;
     }
 
-    inline Cell &cellat(int x, int y) {
+    inline Cell cellat(int x, int y) {
         if ((x < 0)||(x >= w)||(y < 0)||(y>=h))
-            return Cell::outside_cell;
-        return cls[y*w + x];
+            return Cell();
+        return Cell(this, y*w + x);
     }
 
-    Cell &cellat(Coord &c) {
+    Cell cellat(Coord &c) {
         return cellat(c.x, c.y);
     }
 
-    Cell &operator()(int x, int y) { return cellat(x, y); }
-    Cell &operator()(Coord &c) { return cellat(c); }
-    Cell &operator()(int p) { return cellno(p); }
+    Cell operator()(int x, int y) { return cellat(x, y); }
+    Cell operator()(Coord &c) { return cellat(c); }
+    Cell operator()(int p) { return cellno(p); }
 
     void load_template(std::istream &stream);
     void load(const std::string &fn);
@@ -174,48 +217,108 @@ public:
 
     int getempty();
 
-    // statistics
-
+    // flat word structure
+    int numslots() { return slotstart.size() - 1; }
+    int slotlength(int s) { return slotstart[s+1] - slotstart[s]; }
+    int slotcell(int s, int pos) { return slotcells[slotstart[s] + pos]; }
+    // copies the symbols of slot s to word, which has room for them
+    void getword(int s, Symbol *word) {
+        for (int k = slotstart[s]; k < slotstart[s+1]; k++)
+            *word++ = symbols[slotcells[k]];
+    }
+    int numcellslots(int cno) { return cellstart[cno+1] - cellstart[cno]; }
+    int cellslot(int cno, int i) { return cellslots[cellstart[cno] + i]; }
+    int cellpos(int cno, int i) { return cellslotpos[cellstart[cno] + i]; }
+
+    // letters allowed in cell cno by all its words, cached per word
+    SymbolSet findpossible(int cno, Dict &d);
+    // sets score[symbol value] of every letter allowed in cno to the
+    // lowest of the best scores its words give it. Not cached.
+    SymbolSet scoreletters(int cno, Dict &d, int *score);
+
+    void invalidateslot(int s);
+
+    // changes that are logged on the trail. Solvers must make all their
+    // changes through these for rollback() to be correct.
+    void setsymbol(int cno, Symbol s);
+    void clear(int cno, bool setpreferred = true);
+
+    size_t mark() { return trail.size(); }
+    // undoes every logged change and domain change since the mark.
+    // Without undopreferred, the preferred symbols saved by clear()
+    // stay as they are.
+    void rollback(size_t mark, bool undopreferred = true);
+    // forgets every cached domain along with the trail
+    void resetdomains();
+
+    // the fill state of every cell, as a plain value
+    struct Snapshot {
+        std::vector<Symbol> symbols;
+        std::vector<Symbol> preferred;
+        std::vector<char> locked;
+    };
+    Snapshot snapshot();
+    // brings the cells back to the snapshot and drops the trail and
+    // the claimed words
+    void restore(const Snapshot &s);
+
+    // claims the words of the slots of cno that are complete. Returns
+    // false if one of them is claimed by another slot already. Claims
+    // are logged and given up by rollback().
+    bool claimwords(int cno, Dict &d);
+    // claims the words of all complete slots anew
+    bool claimall(Dict &d);
+    // letters for the empty cell cno that don't complete a slot with a
+    // word claimed already
+    SymbolSet findunused(int cno, Dict &d);
+    const UsedWords &usedwords() { return used; }
+
+    // statistics. The pattern ones are cached, see GridShape.
+
+    // share of the inside cells that are in two words
     float interlockdegree();
+    // share of the cells that are inside
     float density();
     float attemptaverage();
     int numopen();
-    int numcells() { return cls.size(); }
+    int numcells() { return ncells; }
+    // average of celldependencies() over the inside cells
     double dependencydegree(int level);
+    // cells within level word steps of cellno, itself included
     int celldependencies(int cellno, int level);
+    // the inside cells, those with the most cells within two word
+    // steps first. A hint for walkers where to start.
+    const std::vector<int> &dependencyorder();
 
     // build clue numbering
     Answers getanswers();
 };
 
 
-struct CellRef {
-    int cellno;
-    Grid *g;
-    CellRef(int no, Grid &gr) : cellno(no), g(&gr) {}
-    Cell *operator ->() { return &g->cellno(cellno); }
-    Cell *ptr() { return &g->cellno(cellno); }
-};
+Symbol Cell::getsymbol() {
+    return n < 0 ? Symbol::outside : g->symbols[n];
+}
 
+Symbol Cell::getpreferred() {
+    return n < 0 ? Symbol::none : g->preferred[n];
+}
 
-class WordBlock {
-    std::vector<CellRef> cls; int cls_size;
-public:
-    WordBlock();
-    void addcell(int n, Grid &gr) {
-        cls.push_back(CellRef(n, gr));
-        cls_size++;
-    }
-    int length() { return cls_size; }
-    void getword(Symbol *);
-    int getcellno(int pos) {
-        if ((pos < 0)||(pos >= cls_size)) throw error("Bug");
-        return cls[pos].cellno;
-    }
-    Cell &getcell(int pos) {
-        if ((pos < 0)||(pos >= cls_size)) return Cell::outside_cell;
-        return *cls[pos].ptr();
-    }
-};
+void Cell::setpreferred(Symbol s) {
+    if (n >= 0)
+        g->preferred[n] = s;
+}
+
+int Cell::getattempts() {
+    return n < 0 ? 0 : g->attempts[n];
+}
+
+bool Cell::islocked() {
+    return n >= 0 && g->locked[n];
+}
+
+void Cell::lock() {
+    if (n >= 0)
+        g->locked[n] = true;
+}
 
 #endif // CWC_GRID_HH
@@ -0,0 +1,55 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include "gridkernel.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class gridkernel
+
+/**
+ * The fixed kernels rely on the word layout buildwords() produces for
+ * square grids: two words per open cell, across first. Anything else
+ * (such as grids loaded as word lists) gets no kernel.
+ */
+
+GridKernel *GridKernel::create(Grid &g) {
+    int n = g.numcells();
+    if (n != g.w * g.h)
+        return 0;
+    for (int c = 0; c < n; c++) {
+        if (g(c).isoutside())
+            continue;
+        if (g.numcellslots(c) != 2)
+            return 0;
+        int across = g.cellslot(c, 0), down = g.cellslot(c, 1);
+        int apos = g.cellpos(c, 0), dpos = g.cellpos(c, 1);
+        if (g.slotcell(across, 0) != c - apos || g.slotcell(down, 0) != c - dpos * g.w)
+            return 0;
+    }
+
+    if (g.w == 13 && g.h == 13)
+        return new FixedGridKernel<13, 13>(g);
+    if (g.w == 15 && g.h == 15)
+        return new FixedGridKernel<15, 15>(g);
+    if (g.w == 21 && g.h == 21)
+        return new FixedGridKernel<21, 21>(g);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_GRIDKERNEL_HH
+#define CWC_GRIDKERNEL_HH
+
+#include <array>
+
+#include "grid.hh"
+
+/**
+ * A grid kernel answers Grid::findpossible() for one particular grid
+ * shape. Grid::buildwords() asks create() for a kernel matching the
+ * grid just built and dispatches to it when there is one.
+ *
+ * The fixed kernels cover the square grid sizes we fill the most. In
+ * a square grid every open cell has one across and one down word, so
+ * the kernel keeps the start, length and position of both per cell in
+ * fixed size arrays and reads the words with strides known at compile
+ * time, instead of going through the generic slot tables.
+ */
+
+class GridKernel {
+public:
+    virtual ~GridKernel() {}
+    virtual SymbolSet findpossible(Grid &g, int cno, Dict &d) const = 0;
+
+    // a kernel for the shape of g, or 0 if there is none
+    static GridKernel *create(Grid &g);
+
+protected:
+    // the kernels get at the grid through these
+    static const Symbol *cells(Grid &g) { return &g.symbols[0]; }
+    static SymbolSet *domains(Grid &g) { return &g.domains[0]; }
+    static char *domainvalid(Grid &g) { return &g.domainvalid[0]; }
+    static int firstentry(Grid &g, int cno) { return g.cellstart[cno]; }
+    static void usedict(Grid &g, Dict &d) {
+        if (g.domaindict != &d) {
+            g.domainvalid.assign(g.domainvalid.size(), 0);
+            g.domaindict = &d;
+        }
+    }
+};
+
+template<int W, int H>
+class FixedGridKernel : public GridKernel {
+    // per cell: first cell, length and position of its across and down
+    // word. Start cells of outside cells are -1.
+    std::array<short, W*H> acrossstart, downstart;
+    std::array<unsigned char, W*H> acrosslen, downlen, acrosspos, downpos;
+
+    template<int STRIDE, int MAXLEN>
+    static SymbolSet query(const Symbol *cl, int start, int len, int pos, Dict &d) {
+        Symbol word[MAXLEN + 1];
+        for (int p = 0; p < len; p++)
+            word[p] = cl[start + p * STRIDE];
+        word[len] = Symbol::outside;
+        return d.findpossible(word, len, pos);
+    }
+
+public:
+    FixedGridKernel(Grid &g);
+
+    SymbolSet findpossible(Grid &g, int cno, Dict &d) const override {
+        usedict(g, d);
+        const Symbol *cl = cells(g);
+        SymbolSet *dom = domains(g);
+        char *valid = domainvalid(g);
+        // the across word is always entered before the down word
+        int e = firstentry(g, cno);
+        if (!valid[e]) {
+            CWC_COUNT(g.stats, query(d));
+            dom[e] = query<1, W>(cl, acrossstart[cno], acrosslen[cno], acrosspos[cno], d);
+            valid[e] = 1;
+        } else
+            CWC_COUNT(g.stats, domainhit());
+        if (!valid[e+1]) {
+            CWC_COUNT(g.stats, query(d));
+            dom[e+1] = query<W, H>(cl, downstart[cno], downlen[cno], downpos[cno], d);
+            valid[e+1] = 1;
+        } else
+            CWC_COUNT(g.stats, domainhit());
+        return dom[e] & dom[e+1];
+    }
+};
+
+template<int W, int H>
+FixedGridKernel<W, H>::FixedGridKernel(Grid &g) {
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int c = y*W + x;
+            acrossstart[c] = downstart[c] = -1;
+            acrosslen[c] = downlen[c] = acrosspos[c] = downpos[c] = 0;
+            if (g(x, y).isoutside())
+                continue;
+            int x0 = x, y0 = y;
+            while (g(x0-1, y).isinside()) x0--;
+            while (g(x, y0-1).isinside()) y0--;
+            int x1 = x, y1 = y;
+            while (g(x1+1, y).isinside()) x1++;
+            while (g(x, y1+1).isinside()) y1++;
+            acrossstart[c] = y*W + x0;
+            acrosslen[c] = x1 - x0 + 1;
+            acrosspos[c] = x - x0;
+            downstart[c] = y0*W + x;
+            downlen[c] = y1 - y0 + 1;
+            downpos[c] = y - y0;
+        }
+    }
+}
+
+#endif // CWC_GRIDKERNEL_HH
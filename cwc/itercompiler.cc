@@ -0,0 +1,359 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+#include "itercompiler.hh"
+#include "trace.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class iterative_compiler
+//
+// Every frame on the stack stands for a filled cell, except the top
+// one, whose letter (bit) is the next to place. The steps correspond to
+// those of Compiler::compile_rest: entering a cell, placing a letter,
+// and running out of letters, upon which the backtracker moves the
+// walker and the frames it stepped past are dropped.
+
+IterativeCompiler::IterativeCompiler(Grid &thegrid, Walker &thewalker,
+                                     Backtracker &thebacktracker, Dict &thedict)
+    : findall(false), nodupes(false), scored(false), stats(0),
+      g(thegrid), w(thewalker), bt(thebacktracker), d(thedict),
+      state(running), started(false), numcells(0), numalpha(0),
+      rejected(0), nodes(0), solutions(0), seed(rand()),
+      pauseflag(false), cancelflag(false) {
+}
+
+void IterativeCompiler::start() {
+    w.forward();
+    numcells = g.numopen();
+    numalpha = Symbol::numalpha();
+    solutions = 0;
+    started = true;
+    CWC_TRACE(trace_compiler, trace_info, "compiling " << numcells << " cells");
+    if (nodupes && !g.claimall(d)) {
+        // the given words repeat already
+        state = exhausted;
+        return;
+    }
+    enter(0);
+}
+
+void IterativeCompiler::enter(double rejected) {
+    Frame f;
+    f.cell = w.getCurrent();
+    CWC_TRACE(trace_compiler, trace_debug, "attempting to find solution for " << f.cell);
+    SymbolSet ss = g.findpossible(f.cell, d);
+    if (nodupes)
+        ss &= g.findunused(f.cell, d);
+    int npossible = numones(ss);
+    rejected += (numalpha-double(npossible)) * pow(numalpha, numcells - w.stepCount());
+    CWC_COUNT(stats, domain(f.cell, npossible));
+    CWC_TRACE(trace_compiler, trace_debug, "possible " << setstring(ss));
+
+    // use preferred if any
+    f.bit = 0;
+    f.hasscores = false;
+    if (g(f.cell).haspreferred()) {
+        SymbolSet ss2 = g(f.cell).getpreferred().getsymbolset();
+        if (ss2 & ss) {
+            f.bit = ss2;
+            ss &= ~ss2;
+        }
+    }
+    f.remaining = ss;
+    if (!f.bit)
+        f.bit = nextbit(f);
+    f.rejected = rejected;
+    f.mark = g.mark();
+    stack.push_back(f);
+}
+
+// the next letter to try in the frame, with the grid as it was when the
+// frame was entered
+SymbolSet IterativeCompiler::nextbit(Frame &f) {
+    if (!scored)
+        return pickbit(f.remaining, &seed);
+    if (!f.hasscores) {
+        g.scoreletters(f.cell, d, f.score);
+        f.hasscores = true;
+    }
+    return pickbest(f.remaining, f.score, &seed);
+}
+
+// takes back the letter of the frame and everything after it
+void IterativeCompiler::rollback(const Frame &f) {
+    if (f.mark == restoredmark) {
+        g.setsymbol(f.cell, Symbol::empty);
+        g.resetdomains();
+        if (nodupes)
+            g.claimall(d);
+    } else
+        g.rollback(f.mark, false);
+}
+
+// the top cell has no letters left. Returns false when the search
+// space is used up.
+bool IterativeCompiler::backtrack() {
+    int c = stack.back().cell;
+    stack.pop_back();
+    if (w.stepCount() > 1) {
+        CWC_COUNT(stats, backtrack(w.stepCount()));
+        bt.backtrack(w);
+        CWC_COUNT(stats, backjump(w.stepCount()));
+        CWC_TRACE(trace_compiler, trace_debug, "return to " << w.getCurrent() << " from " << c);
+    }
+    while (!stack.empty() && stack.back().cell != w.getCurrent())
+        stack.pop_back();
+    if (stack.empty())
+        return false;
+
+    Frame &f = stack.back();
+    f.rejected += pow(numalpha, numcells - w.stepCount());
+    rollback(f);
+    f.bit = nextbit(f);
+    return true;
+}
+
+IterativeCompiler::state_t IterativeCompiler::step(long n) {
+    if (finished())
+        return state;
+    g.stats = stats;
+    CWC_COUNT(stats, start());
+    if (!started)
+        start();
+    if (!finished())
+        search(n);
+    if (finished())
+        CWC_TRACE(trace_compiler, trace_info, "finished in state " << state << " after " << nodes << " nodes");
+    CWC_COUNT(stats, stop());
+    g.stats = 0;
+    return state;
+}
+
+IterativeCompiler::state_t IterativeCompiler::search(long n) {
+    for (long i = 0; n <= 0 || i < n; ) {
+        if (cancelflag.load(std::memory_order_relaxed))
+            return state = cancelled;
+        if (pauseflag.load(std::memory_order_relaxed))
+            return state = paused;
+
+        if (!stack.back().bit) {
+            if (!backtrack())
+                return state = exhausted;
+            continue;
+        }
+
+        Frame &f = stack.back();
+        g.setsymbol(f.cell, Symbol::symbolbit(f.bit));
+        nodes++;
+        i++;
+        CWC_COUNT(stats, node(w.stepCount()));
+        if (nodupes && !g.claimwords(f.cell, d)) {
+            rollback(f);
+            f.bit = nextbit(f);
+            continue;
+        }
+        if (w.moresteps()) {
+            w.forward();
+            enter(f.rejected); // f is gone after this
+        } else {
+            rejected = f.rejected;
+            CWC_COUNT(stats, solution());
+            if (!findall)
+                return state = solved;
+            // count the fill and go on with the next letter
+            solutions++;
+            rollback(f);
+            f.bit = nextbit(f);
+        }
+    }
+    return state = running;
+}
+
+IterativeCompiler::state_t IterativeCompiler::run(long maxnodes, long maxmsecs) {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point deadline = clock::now() + std::chrono::milliseconds(maxmsecs);
+    long until = nodes + maxnodes;
+    const long slice = 256;
+
+    for (;;) {
+        long n = slice;
+        if (maxnodes > 0) {
+            if (nodes >= until)
+                return state;
+            if (until - nodes < n)
+                n = until - nodes;
+        }
+        if (step(n) != running)
+            return state;
+        if (maxmsecs > 0 && clock::now() >= deadline)
+            return state;
+    }
+}
+
+bool IterativeCompiler::compile() {
+    run();
+    if (findall)
+        return solutions > 0;
+    return state == solved;
+}
+
+void IterativeCompiler::resume() {
+    pauseflag = false;
+    if (state == paused)
+        state = running;
+}
+
+//////////////////////////////////////////////////////////////////////
+// checkpoints
+//
+// Letters are written as characters, as symbol numbers depend on the
+// order the dictionary was loaded in. '-' stands for no letter.
+
+static void putletters(std::ostream &os, SymbolSet ss) {
+    if (!ss) {
+        os << '-';
+        return;
+    }
+    for (SymbolSet bit = 1; bit; bit <<= 1)
+        if (ss & bit)
+            os << char(Symbol::symbolbit(bit));
+}
+
+static SymbolSet getletters(std::istream &is) {
+    std::string s;
+    is >> s;
+    if (s == "-")
+        return 0;
+    SymbolSet ss = 0;
+    for (size_t i = 0; i < s.size(); i++)
+        ss |= Symbol(s[i]).getsymbolset();
+    return ss;
+}
+
+void IterativeCompiler::save(std::ostream &os) {
+    if (!started)
+        throw error("Nothing to save before the first step");
+    std::streamsize precision = os.precision(17);
+
+    os << "cwcsearch 2" << std::endl;
+    os << "state " << int(state) << ' ' << findall << ' ' << nodupes << ' ' << numcells << ' '
+       << numalpha << ' ' << nodes << ' ' << solutions << ' ' << seed << ' '
+       << rejected << std::endl;
+
+    int ncells = g.numcells(), nopen = 0;
+    for (int i = 0; i < ncells; i++)
+        if (g(i).isinside() && !g(i).islocked())
+            nopen++;
+    os << "cells " << ncells << ' ' << nopen << std::endl;
+    for (int i = 0; i < ncells; i++) {
+        if (g(i).isoutside() || g(i).islocked())
+            continue;
+        os << i << ' ' << char(g(i).getsymbol()) << ' ' << char(g(i).getpreferred()) << std::endl;
+    }
+
+    w.save(os);
+
+    os << "frames " << stack.size() << std::endl;
+    for (size_t i = 0; i < stack.size(); i++) {
+        const Frame &f = stack[i];
+        os << f.cell << ' ';
+        putletters(os, f.bit);
+        os << ' ';
+        putletters(os, f.remaining);
+        os << ' ' << f.rejected << std::endl;
+    }
+
+    bt.save(os);
+    os << "end" << std::endl;
+    os.precision(precision);
+}
+
+void IterativeCompiler::restore(std::istream &is) {
+    std::string tag;
+    int version, st;
+    is >> tag >> version;
+    if (!is || tag != "cwcsearch" || version < 1 || version > 2)
+        throw error("Not a search checkpoint");
+
+    // version 1 had no nodupes
+    is >> tag >> st >> findall;
+    if (version >= 2)
+        is >> nodupes;
+    else
+        nodupes = false;
+    is >> numcells >> numalpha >> nodes >> solutions >> seed >> rejected;
+    if (!is || tag != "state")
+        throw error("Bad search state");
+    state = state_t(st);
+    if (state == paused)
+        state = running;
+
+    int ncells, nopen;
+    is >> tag >> ncells >> nopen;
+    if (!is || tag != "cells" || ncells != g.numcells())
+        throw error("Checkpoint is for another grid");
+    for (int k = 0; k < nopen; k++) {
+        int i;
+        char symb, pref;
+        is >> i >> symb >> pref;
+        if (!is || g(i).isoutside() || g(i).islocked())
+            throw error("Checkpoint is for another grid");
+        g(i).setsymbol(Symbol(symb));
+        g(i).setpreferred(Symbol(pref));
+    }
+
+    w.restore(is);
+
+    size_t nframes;
+    is >> tag >> nframes;
+    if (!is || tag != "frames")
+        throw error("Bad search state");
+    stack.clear();
+    for (size_t i = 0; i < nframes; i++) {
+        Frame f;
+        is >> f.cell;
+        f.bit = getletters(is);
+        f.remaining = getletters(is);
+        is >> f.rejected;
+        // the trail is not saved, so rolling back to one of these
+        // frames starts the domains over from scratch
+        f.mark = restoredmark;
+        f.hasscores = false;
+        stack.push_back(f);
+    }
+
+    bt.restore(is);
+    is >> tag;
+    if (!is || tag != "end")
+        throw error("Bad search state");
+
+    g.resetdomains();
+    if (nodupes)
+        g.claimall(d);
+    started = true;
+    pauseflag = false;
+    cancelflag = false;
+}
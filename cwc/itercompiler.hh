@@ -0,0 +1,119 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_ITERCOMPILER_HH
+#define CWC_ITERCOMPILER_HH
+
+#include <atomic>
+#include <vector>
+#include <iostream>
+
+#include "cwc.hh"
+
+/**
+ * The iterative compiler runs the same search as Compiler, but keeps
+ * one frame per filled cell on an explicit stack instead of recursing,
+ * so open cells are only limited by memory. The search can be run a
+ * few nodes at a time, paused, cancelled and given a node or time
+ * budget. Given the same seed it fills exactly like Compiler.
+ *
+ * save() writes the complete search state as text; restore() reads it
+ * back into a compiler set up on a fresh copy of the same grid, with
+ * the same walker and backtracker types and a dictionary with the same
+ * words, after which the search continues where it left off.
+ */
+
+class IterativeCompiler {
+public:
+    typedef enum { running, paused, solved, exhausted, cancelled } state_t;
+
+    IterativeCompiler(Grid &thegrid, Walker &thewalker,
+                      Backtracker &thebacktracker, Dict &thedict);
+
+    // fills at most n cells (n <= 0 means no limit)
+    state_t step(long n);
+    // runs until finished or paused, or until maxnodes cells have been
+    // filled or maxmsecs have passed (zero means no limit)
+    state_t run(long maxnodes = 0, long maxmsecs = 0);
+    bool compile();
+
+    // pause() and cancel() may be called from any thread and take
+    // effect at the next node. A paused search goes on after resume().
+    void pause() { pauseflag = true; }
+    void resume();
+    void cancel() { cancelflag = true; }
+
+    void save(std::ostream &os);
+    void restore(std::istream &is);
+
+    state_t getState() { return state; }
+    bool finished() { return state == solved || state == exhausted || state == cancelled; }
+    long getNodes() { return nodes; }
+    // number of complete fills seen when findall is set
+    long getSolutions() { return solutions; }
+    double getRejected() { return rejected; }
+    int getDepth() { return stack.size(); }
+    void setSeed(unsigned int s) { seed = s; }
+
+    bool findall;
+    // as in Compiler
+    bool nodupes, scored;
+    SearchStats *stats;
+
+protected:
+    struct Frame {
+        int cell;
+        // letter to try next (none left when zero) and the ones after it
+        SymbolSet bit;
+        SymbolSet remaining;
+        double rejected;
+        size_t mark;
+        // letter scores when scored is set, worked out at the first pick
+        bool hasscores;
+        int score[MAXSYMBOLS];
+    };
+    // marks from before a restore point into a trail that is gone
+    static const size_t restoredmark = size_t(-1);
+
+    Grid &g;
+    Walker &w;
+    Backtracker &bt;
+    Dict &d;
+    std::vector<Frame> stack;
+    state_t state;
+    bool started;
+    int numcells;
+    int numalpha;
+    double rejected;
+    long nodes;
+    long solutions;
+    unsigned int seed;
+    std::atomic<bool> pauseflag, cancelflag;
+
+    void start();
+    state_t search(long n);
+    void enter(double rejected);
+    SymbolSet nextbit(Frame &f);
+    bool backtrack();
+    void rollback(const Frame &f);
+};
+
+#endif // CWC_ITERCOMPILER_HH
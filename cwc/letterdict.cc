@@ -22,6 +22,7 @@
 #include <fstream>
 #include <algorithm>
 #include <iostream>
+#include <limits.h>
 
 #include "letterdict.hh"
 
@@ -84,7 +85,7 @@ void LetterDict::addword(Symbol *st, int wordi) {
     // for each position in the word
     for (int pos=0; pos<wlen; pos++) {
         if (p[wlen][pos] == 0)
-            p[wlen][pos] = newptrarray<intvec>(32);
+            p[wlen][pos] = newptrarray<intvec>(MAXSYMBOLS);
         int chval = st[pos].symbvalue();
         if (p[wlen][pos][chval] == 0)
             p[wlen][pos][chval] = new intvec;
@@ -106,7 +107,31 @@ LetterDict::intvec *LetterDict::getintvec(int len, int pos, Symbol s) {
 }
 
 SymbolSet LetterDict::findpossible(Symbol *s, int len, int pos) {
-    if (len == 1) return wl->allalpha;
+    return intersect(s, len, pos, 0, 0);
+}
+
+int LetterDict::wordid(Symbol *s, int len) {
+    return wl->find(s, len);
+}
+
+SymbolSet LetterDict::findunused(Symbol *s, int len, int pos, const UsedWords &used) {
+    return intersect(s, len, pos, &used, 0);
+}
+
+SymbolSet LetterDict::findscored(Symbol *s, int len, int pos, int *best) {
+    return intersect(s, len, pos, 0, best);
+}
+
+// words in used, if any, don't count. Postings are in word number
+// order, which is score order, so the first word found with a symbol
+// gives its best score.
+SymbolSet LetterDict::intersect(Symbol *s, int len, int pos, const UsedWords *used, int *best) {
+    if (len == 1) {
+        // one letter slots take any letter and rule nothing out
+        for (SymbolSet m = best ? wl->allalpha : 0; m; m &= m - 1)
+            best[firstbit(m)] = INT_MAX;
+        return wl->allalpha;
+    }
 
     intvec *chpset[len];
     int nsets = 0;
@@ -120,6 +145,10 @@ SymbolSet LetterDict::findpossible(Symbol *s, int len, int pos) {
         if (all[len] == 0)
             return 0;
         // dumpset(all[len][pos]);
+        for (SymbolSet m = best ? all[len][pos] : 0; m; m &= m - 1) {
+            int sym = firstbit(m);
+            best[sym] = wl->score(p[len][pos][sym]->front());
+        }
         return all[len][pos];
     }
 
@@ -144,7 +173,12 @@ SymbolSet LetterDict::findpossible(Symbol *s, int len, int pos) {
             // cout << (*wl)[*it[i]] << ' ';
             // cout << endl;
             int wnum = *it[0];
-            ss |= (*wl)[wnum][pos].getsymbolset();
+            if (!used || !used->test(wnum)) {
+                SymbolSet bit = (*wl)[wnum][pos].getsymbolset();
+                if (best && !(ss & bit))
+                    best[(*wl)[wnum][pos].symbvalue()] = wl->score(wnum);
+                ss |= bit;
+            }
 
             for (int i=0;i<nsets;i++) {
                 it[i]++;
@@ -175,6 +209,7 @@ void LetterDict::load(const std::string &fn)
     std::cout << "Loading wordlist and building dictionary... " << std::flush;
 
     wl = new WordList();
+    wl->minscore = minscore;
     wl->load(fn);
 
     int nwords = wl->numwords();
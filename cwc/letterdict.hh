@@ -40,7 +40,12 @@ public:
     void addword(Symbol *i, int wordi);
     intvec *getintvec(int len, int pos, Symbol s);
     SymbolSet findpossible(Symbol *, int len, int pos);
+    int wordid(Symbol *s, int len);
+    SymbolSet findunused(Symbol *s, int len, int pos, const UsedWords &used);
+    SymbolSet findscored(Symbol *s, int len, int pos, int *best);
     void load(const std::string &fn);
+private:
+    SymbolSet intersect(Symbol *s, int len, int pos, const UsedWords *used, int *best);
 };
 
 #endif // CWC_LETTERDICT_HH
@@ -37,7 +37,7 @@ public:
 struct setup_s {
     typedef enum { simple_format, ascii_format } output_format_t;
     typedef enum { prefixwalker, floodwalker } walker_t;
-    typedef enum { btreedict, letterdict } dict_t;
+    typedef enum { btreedict, letterdict, bitmapdict, dawgdict, mmapdict } dict_t;
     typedef enum { noformat, generalgrid, squaregrid } gridformat_t;
     output_format_t output_format;
     walker_t walkertype;
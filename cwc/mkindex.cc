@@ -0,0 +1,49 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+/**
+ * mkindex - builds the prebuilt dictionary index used by MmapDict.
+ *
+ * usage: mkindex <wordlist> <indexfile>
+ *
+ * g++ -std=c++14 -O2 mkindex.cc mmapdict.cc wordlist.cc symbol.cc dict.cc -o mkindex
+ **/
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "mmapdict.hh"
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <wordlist> <indexfile>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Symbol::buildindex();
+    try {
+        MmapDict::build(argv[1], argv[2]);
+    } catch (error &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
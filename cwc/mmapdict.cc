@@ -0,0 +1,299 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mmapdict.hh"
+#include "wordlist.hh"
+
+static const char indexmagic[8] = { 'C', 'W', 'C', 'I', 'N', 'D', 'E', 'X' };
+static const uint32_t byteordermark = 0x01020304;
+
+static uint32_t padded(size_t n) {
+    return (n + 3) / 4 * 4;
+}
+
+//////////////////////////////////////////////////////////////////////
+// mmapdict
+
+MmapDict::MmapDict()
+    : base(0), mapsize(0), header(0), symbols(0), words(0), table(0),
+      postings(0), allalpha(0) {
+}
+
+MmapDict::~MmapDict() {
+    unmap();
+}
+
+void MmapDict::unmap() {
+    if (base)
+        munmap((void *)base, mapsize);
+    base = 0;
+    header = 0;
+}
+
+SymbolSet MmapDict::translate(uint32_t ss) {
+    SymbolSet r = 0;
+    for (; ss; ss &= ss - 1)
+        r |= fromfile[firstbit(ss)];
+    return r;
+}
+
+void MmapDict::load(const std::string &fn) {
+    std::cout << "Mapping dictionary index... " << std::flush;
+    unmap();
+
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw error("Failed to open dictionary index");
+    struct stat st;
+    if (fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        throw error("Invalid dictionary index");
+    }
+    mapsize = st.st_size;
+    void *p = mmap(0, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw error("Failed to map dictionary index");
+    base = (const char *)p;
+    header = (const Header *)base;
+
+    if (memcmp(header->magic, indexmagic, sizeof(indexmagic)) != 0
+        || header->byteorder != byteordermark) {
+        unmap();
+        throw error("Not a dictionary index");
+    }
+    if (header->version != version) {
+        unmap();
+        throw error("Unsupported dictionary index version");
+    }
+    if (header->filesize != mapsize) {
+        unmap();
+        throw error("Truncated dictionary index");
+    }
+    if (!checkindex()) {
+        unmap();
+        throw error("Corrupt dictionary index");
+    }
+
+    for (int i = 0; i < MAXSYMBOLS; i++)
+        tofile[i] = -1;
+    for (int i = 0; i < filesymbols; i++) {
+        fromfile[i] = 0;
+        char ch = header->alphabet[i];
+        if (ch == 0)
+            continue;
+        Symbol s(ch);
+        fromfile[i] = s.getsymbolset();
+        tofile[s.symbvalue()] = i;
+    }
+
+    allalpha = translate(header->allalpha);
+    const uint32_t *fileall = (const uint32_t *)(base + header->alloff);
+    for (int i = 0; i < numlenpos; i++)
+        all[i] = translate(fileall[i]);
+
+    std::cout << "ok" << std::endl;
+    std::cout << header->nwords << " words." << std::endl;
+}
+
+/**
+ * checks that the sections follow each other as build() lays them out
+ * and that every posting, word offset and symbol the lookups follow
+ * stays inside them, then sets the section pointers. This reads the
+ * postings and symbols once, so a damaged file is turned down here
+ * rather than read past its end later.
+ */
+
+bool MmapDict::checkindex() {
+    const Header &h = *header;
+    uint64_t ntable = uint64_t(numlenpos) * filesymbols * 2;
+    if (h.symbolsoff != padded(sizeof(Header))
+        || uint64_t(h.symbolsoff) + h.symbolslen > h.wordsoff
+        || h.wordsoff != h.symbolsoff + uint64_t(padded(h.symbolslen))
+        || h.tableoff != h.wordsoff + uint64_t(h.nwords) * 4
+        || h.postingsoff != h.tableoff + ntable * 4
+        || h.alloff != h.postingsoff + uint64_t(h.npostings) * 4
+        || uint64_t(h.filesize) != h.alloff + uint64_t(numlenpos) * 4)
+        return false;
+
+    symbols = (const unsigned char *)(base + h.symbolsoff);
+    words = (const uint32_t *)(base + h.wordsoff);
+    table = (const uint32_t *)(base + h.tableoff);
+    postings = (const uint32_t *)(base + h.postingsoff);
+
+    // the longest word length each word is posted under; lookups read
+    // that many of its symbols
+    std::vector<unsigned char> need(h.nwords, 0);
+    for (int len = 2; len < MAXWORDLEN; len++) {
+        for (int pos = 0; pos < len; pos++) {
+            for (int fs = 0; fs < filesymbols; fs++) {
+                const uint32_t *entry = table + 2 * (lenpos(len, pos) * filesymbols + fs);
+                if (uint64_t(entry[0]) + entry[1] > h.npostings)
+                    return false;
+                for (uint32_t i = entry[0]; i < entry[0] + entry[1]; i++) {
+                    if (postings[i] >= h.nwords)
+                        return false;
+                    need[postings[i]] = len;
+                }
+            }
+        }
+    }
+    for (uint32_t w = 0; w < h.nwords; w++) {
+        if (uint64_t(words[w]) + need[w] > h.symbolslen)
+            return false;
+        for (int pos = 0; pos < need[w]; pos++)
+            if (symbols[words[w] + pos] >= filesymbols)
+                return false;
+    }
+    return true;
+}
+
+SymbolSet MmapDict::findpossible(Symbol *s, int len, int pos) {
+    if (len == 1) return allalpha;
+    if (len >= MAXWORDLEN) return 0;
+
+    const uint32_t *it[len], *end[len];
+    int nsets = 0;
+
+    for (int i = 0; i < len; i++) {
+        if (s[i] == Symbol::empty)
+            continue;
+        int fs = tofile[s[i].symbvalue()];
+        if (fs < 0)
+            return 0;
+        const uint32_t *entry = table + 2 * (lenpos(len, i) * filesymbols + fs);
+        if (entry[1] == 0)
+            return 0;
+        it[nsets] = postings + entry[0];
+        end[nsets] = it[nsets] + entry[1];
+        nsets++;
+    }
+
+    if (nsets == 0)
+        return all[lenpos(len, pos)];
+
+    // same intersection as LetterDict, on the mapped postings
+    uint32_t ss = 0;
+    while (1) {
+        bool allequal = true;
+        for (int i = 0; i < nsets - 1; i++)
+            allequal &= (*it[i] == *it[i+1]);
+        if (allequal) {
+            ss |= uint32_t(1) << symbols[words[*it[0]] + pos];
+            for (int i = 0; i < nsets; i++) {
+                if (++it[i] == end[i])
+                    return translate(ss);
+            }
+        } else {
+            int sm = 0;
+            for (int i = 1; i < nsets; i++)
+                if (*it[i] < *it[sm])
+                    sm = i;
+            if (++it[sm] == end[sm])
+                break;
+        }
+    }
+    return translate(ss);
+}
+
+//////////////////////////////////////////////////////////////////////
+// index builder
+
+static void writepadded(std::ofstream &f, const void *data, size_t n) {
+    f.write((const char *)data, n);
+    static const char zero[4] = { 0, 0, 0, 0 };
+    f.write(zero, (4 - n % 4) % 4);
+}
+
+void MmapDict::build(const std::string &wordfile, const std::string &indexfile) {
+    WordList wl;
+    wl.load(wordfile);
+    int nwords = wl.numwords();
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, indexmagic, sizeof(indexmagic));
+    h.version = version;
+    h.byteorder = byteordermark;
+    if (Symbol::numsymbols() > filesymbols)
+        throw error("Alphabet too large for a dictionary index");
+    for (int i = 0; i < filesymbols; i++)
+        h.alphabet[i] = (Symbol::letter(i) == UNDEF) ? 0 : Symbol::letter(i);
+    h.nwords = nwords;
+    h.allalpha = wl.allalpha;
+
+    std::vector<unsigned char> symbs;
+    std::vector<uint32_t> wordoffs;
+    std::vector<std::vector<uint32_t> > lists(numlenpos * filesymbols);
+    std::vector<uint32_t> allsets(numlenpos, 0);
+
+    for (int i = 0; i < nwords; i++) {
+        Symbol *st = wl[i];
+        int len = wordlen(st);
+        wordoffs.push_back(symbs.size());
+        for (int pos = 0; pos <= len; pos++)
+            symbs.push_back(st[pos].symbvalue());
+        if (len >= MAXWORDLEN)
+            continue;
+        for (int pos = 0; pos < len; pos++) {
+            lists[lenpos(len, pos) * filesymbols + st[pos].symbvalue()].push_back(i);
+            allsets[lenpos(len, pos)] |= st[pos].getsymbolset();
+        }
+    }
+
+    std::vector<uint32_t> tab, posts;
+    for (size_t i = 0; i < lists.size(); i++) {
+        tab.push_back(posts.size());
+        tab.push_back(lists[i].size());
+        posts.insert(posts.end(), lists[i].begin(), lists[i].end());
+    }
+
+    h.symbolsoff = padded(sizeof(Header));
+    h.symbolslen = symbs.size();
+    h.wordsoff = h.symbolsoff + padded(symbs.size());
+    h.tableoff = h.wordsoff + wordoffs.size() * 4;
+    h.postingsoff = h.tableoff + tab.size() * 4;
+    h.npostings = posts.size();
+    h.alloff = h.postingsoff + posts.size() * 4;
+    h.filesize = h.alloff + allsets.size() * 4;
+
+    std::ofstream f(indexfile.c_str(), std::ios::binary);
+    if (!f.is_open())
+        throw error("Failed to create dictionary index");
+    writepadded(f, &h, sizeof(h));
+    writepadded(f, symbs.data(), symbs.size());
+    f.write((const char *)wordoffs.data(), wordoffs.size() * 4);
+    f.write((const char *)tab.data(), tab.size() * 4);
+    f.write((const char *)posts.data(), posts.size() * 4);
+    f.write((const char *)allsets.data(), allsets.size() * 4);
+    if (!f)
+        throw error("Failed to write dictionary index");
+}
@@ -0,0 +1,102 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_MMAPDICT_HH
+#define CWC_MMAPDICT_HH
+
+#include <stdint.h>
+#include "symbol.hh"
+#include "dict.hh"
+
+/**
+ * The mmap dictionary works on a prebuilt index file instead of the
+ * word list. The file holds the words, the per (length, position,
+ * symbol) postings and the per (length, position) symbol sets of the
+ * letter dictionary. load() maps it read-only and uses it in place,
+ * so starting up costs one mmap and the pages are shared between all
+ * processes using the same index.
+ *
+ * Index files are made with MmapDict::build() (see mkindex.cc).
+ *
+ * Symbol values depend on the alphabet in use (with the wide one, on
+ * the order in which characters are first seen), so the file records
+ * its alphabet and queries are translated between the file's and the
+ * running program's symbol values. A file holds up to filesymbols
+ * symbols.
+ */
+
+class MmapDict : public Dict {
+public:
+    static const uint32_t version = 1;
+    static const int filesymbols = 32;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteorder;
+        char alphabet[filesymbols];
+        uint32_t nwords;
+        uint32_t allalpha;
+        // word symbols, each word terminated by the outside symbol
+        uint32_t symbolsoff, symbolslen;
+        // one offset into the symbols per word
+        uint32_t wordsoff;
+        // (offset, count) into the postings per (len, pos, symbol)
+        uint32_t tableoff;
+        uint32_t postingsoff, npostings;
+        // one symbol set per (len, pos)
+        uint32_t alloff;
+        uint32_t filesize;
+    };
+
+    MmapDict();
+    ~MmapDict();
+
+    void load(const std::string &fn);
+    SymbolSet findpossible(Symbol *s, int len, int pos);
+
+    static void build(const std::string &wordfile, const std::string &indexfile);
+
+    // index of (len, pos), len < MAXWORDLEN, pos < len
+    static int lenpos(int len, int pos) { return len * (len - 1) / 2 + pos; }
+    static const int numlenpos = MAXWORDLEN * (MAXWORDLEN - 1) / 2;
+
+protected:
+    const char *base;
+    size_t mapsize;
+    const Header *header;
+    const unsigned char *symbols;
+    const uint32_t *words;
+    const uint32_t *table;
+    const uint32_t *postings;
+
+    // file symbol value -> our symbol set, our symbol value -> file value
+    SymbolSet fromfile[filesymbols];
+    int tofile[MAXSYMBOLS];
+    SymbolSet allalpha;
+    SymbolSet all[numlenpos];
+
+    void unmap();
+    bool checkindex();
+    SymbolSet translate(uint32_t ss);
+};
+
+#endif // CWC_MMAPDICT_HH
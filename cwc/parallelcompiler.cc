@@ -0,0 +1,316 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <thread>
+#include <climits>
+#include <algorithm>
+
+#include "cwc.hh"
+#include "parallelcompiler.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class taskqueue
+
+void ParallelCompiler::TaskQueue::push(const Task &t) {
+    std::lock_guard<std::mutex> l(m);
+    q.push_back(t);
+}
+
+bool ParallelCompiler::TaskQueue::pop(Task &t) {
+    std::lock_guard<std::mutex> l(m);
+    if (q.empty())
+        return false;
+    t = q.back();
+    q.pop_back();
+    return true;
+}
+
+bool ParallelCompiler::TaskQueue::steal(Task &t) {
+    std::lock_guard<std::mutex> l(m);
+    if (q.empty())
+        return false;
+    t = q.front();
+    q.pop_front();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// class parallelcompiler
+
+// true if every rank below 'a' comes after 'b', ie. the subtree of 'a'
+// cannot hold a better solution than 'b'.
+static bool rankafter(const std::vector<int> &a, const std::vector<int> &b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i])
+            return a[i] > b[i];
+    }
+    return false;
+}
+
+ParallelCompiler::ParallelCompiler(Grid &thegrid, Dict &thedict)
+    : findall(false), g(thegrid), d(thedict), threads(0), seed(0),
+      splitdepth(3), pending(0), solutions(0), tasks(0), generation(0), best(0),
+      stopped(false), failed(false) {
+}
+
+unsigned int ParallelCompiler::taskseed(const Task &t) {
+    unsigned int s = seed;
+    for (size_t i = 0; i < t.rank.size(); i++)
+        s = s * 31 + t.rank[i] + 1;
+    return s;
+}
+
+bool ParallelCompiler::gettask(int no, Task &t) {
+    if (workers[no]->queue.pop(t))
+        return true;
+    int n = workers.size();
+    for (int i = 1; i < n; i++) {
+        if (workers[(no + i) % n]->queue.steal(t))
+            return true;
+    }
+    return false;
+}
+
+// sets up the worker's grid for a task. Returns false if the task
+// cannot beat the best solution found so far.
+bool ParallelCompiler::starttask(Worker &wk, const Task &t) {
+    {
+        std::lock_guard<std::mutex> l(bestlock);
+        if (stopped || (best && rankafter(t.rank, bestrank)))
+            return false;
+        wk.rank = t.rank;
+        wk.cancelled = false;
+    }
+
+    wk.work.restore(wk.start);
+    for (size_t i = 0; i < t.cells.size(); i++)
+        wk.work(t.cells[i]).setsymbol(t.symbols[i]);
+    wk.work.lock();
+    return true;
+}
+
+void ParallelCompiler::expand(Worker &wk, const Task &t) {
+    Grid &work = wk.work;
+
+    // branch on the empty cell with the fewest candidates
+    int cno = -1, nbest = INT_MAX;
+    SymbolSet ss = 0;
+    int ncells = work.numcells();
+    for (int i = 0; i < ncells; i++) {
+        if (!work(i).isempty())
+            continue;
+        SymbolSet poss = work.findpossible(i, d);
+        int n = numones(poss);
+        if (n == 0)
+            return; // dead end
+        if (n < nbest) {
+            cno = i;
+            nbest = n;
+            ss = poss;
+        }
+    }
+
+    if (cno < 0) {
+        // the prefix filled the whole grid
+        if (findall)
+            solutions++;
+        else
+            found(wk, t);
+        return;
+    }
+
+    std::vector<Task> children;
+    unsigned int s = taskseed(t);
+    int k = 0;
+    for (SymbolSet bit = pickbit(ss, &s); bit; bit = pickbit(ss, &s)) {
+        Task child = t;
+        child.cells.push_back(cno);
+        child.symbols.push_back(Symbol::symbolbit(bit));
+        child.rank.push_back(k++);
+        children.push_back(child);
+    }
+
+    // the owner takes from the back, so push the first branch last
+    pending += children.size();
+    for (int i = children.size() - 1; i >= 0; i--)
+        wk.queue.push(children[i]);
+    signal();
+}
+
+void ParallelCompiler::runleaf(Worker &wk, const Task &t) {
+    Grid &work = wk.work;
+
+    if (work.getempty() == 0) {
+        if (findall)
+            solutions++;
+        else
+            found(wk, t);
+        return;
+    }
+
+    // exhaustive searches need the naive backtracker to stay complete,
+    // first solution searches are much faster with the smart one.
+    FloodWalker w(work);
+    Backtracker *bt;
+    if (findall)
+        bt = new NaiveBacktracker(work);
+    else
+        bt = new SmartBacktracker(work);
+    Compiler c(work, w, *bt, d);
+    c.findall = findall;
+    c.setSeed(taskseed(t));
+    c.setCancelFlag(&wk.cancelled);
+
+    bool ok = c.compile();
+    delete bt;
+    if (findall)
+        solutions += c.getSolutions();
+    else if (ok)
+        found(wk, t);
+}
+
+void ParallelCompiler::found(Worker &wk, const Task &t) {
+    std::lock_guard<std::mutex> l(bestlock);
+    if (best && !rankafter(bestrank, t.rank))
+        return;
+
+    if (best)
+        *best = wk.work;
+    else
+        best = new Grid(wk.work);
+    bestrank = t.rank;
+
+    // stop everybody working on a branch after this one
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (rankafter(workers[i]->rank, bestrank))
+            workers[i]->cancelled = true;
+    }
+}
+
+// wakes the idle threads. Bumping the generation under the lock makes
+// sure a thread about to sleep sees the change.
+void ParallelCompiler::signal() {
+    {
+        std::lock_guard<std::mutex> l(waitlock);
+        generation++;
+    }
+    wakeup.notify_all();
+}
+
+void ParallelCompiler::cancel() {
+    std::lock_guard<std::mutex> l(bestlock);
+    stopped = true;
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i]->cancelled = true;
+}
+
+// keeps the first error and stops the search
+void ParallelCompiler::fail(const std::string &msg) {
+    {
+        std::lock_guard<std::mutex> l(bestlock);
+        if (!failed) {
+            failed = true;
+            failure = msg;
+        }
+    }
+    cancel();
+}
+
+void ParallelCompiler::run(int no) {
+    Worker &wk = *workers[no];
+    Task t;
+    for (;;) {
+        long seen;
+        {
+            std::lock_guard<std::mutex> l(waitlock);
+            seen = generation;
+        }
+        if (!gettask(no, t)) {
+            std::unique_lock<std::mutex> l(waitlock);
+            wakeup.wait(l, [&] { return generation != seen || pending == 0; });
+            if (pending == 0)
+                return;
+            continue;
+        }
+        tasks++;
+        try {
+            if (starttask(wk, t)) {
+                if (int(t.rank.size()) < splitdepth)
+                    expand(wk, t);
+                else
+                    runleaf(wk, t);
+            }
+        } catch (error &e) {
+            fail(e.what());
+        }
+        if (--pending == 0)
+            signal();
+    }
+}
+
+bool ParallelCompiler::compile() {
+    int n = threads;
+    if (n <= 0)
+        n = std::thread::hardware_concurrency();
+    if (n <= 0)
+        n = 1;
+
+    {
+        std::lock_guard<std::mutex> l(bestlock);
+        for (int i = 0; i < n; i++)
+            workers.push_back(new Worker(g));
+    }
+
+    solutions = 0;
+    tasks = 0;
+    pending = 1;
+    workers[0]->queue.push(Task());
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < n; i++)
+        pool.push_back(std::thread(&ParallelCompiler::run, this, i));
+    for (int i = 0; i < n; i++)
+        pool[i].join();
+
+    {
+        std::lock_guard<std::mutex> l(bestlock);
+        for (int i = 0; i < n; i++)
+            delete workers[i];
+        workers.clear();
+    }
+
+    if (failed) {
+        delete best;
+        best = 0;
+        throw error(failure);
+    }
+
+    if (findall)
+        return solutions > 0;
+
+    if (!best)
+        return false;
+    g = *best;
+    delete best;
+    best = 0;
+    return true;
+}
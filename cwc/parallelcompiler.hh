@@ -0,0 +1,136 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_PARALLELCOMPILER_HH
+#define CWC_PARALLELCOMPILER_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "grid.hh"
+#include "dict.hh"
+
+/**
+ * The parallel compiler shares one search tree between all threads.
+ * The top levels of the tree are split into tasks: a task is a
+ * partial fill given as (cell, symbol) pairs. Interior tasks pick the
+ * most constrained empty cell and push one child task per candidate
+ * letter, leaf tasks run an ordinary Compiler on the remaining cells.
+ *
+ * Every thread owns a deque of tasks. It works on the back of its own
+ * deque and, when that runs dry, steals from the front of the others.
+ *
+ * Each task carries its rank, the branch taken at every level. The
+ * solution returned is the one with the smallest rank, so the result
+ * only depends on the seed and the split depth, not on the number of
+ * threads or on scheduling. With findall set, every leaf is searched
+ * exhaustively and the fills are counted.
+ *
+ * Threads without a task sleep until a task is queued or the last one
+ * is done. An error in a task stops the search and is thrown again by
+ * compile().
+ */
+
+class ParallelCompiler {
+public:
+    ParallelCompiler(Grid &thegrid, Dict &thedict);
+
+    // zero means one thread per hardware thread
+    void setThreads(int n) { threads = n; }
+    void setSeed(unsigned int s) { seed = s; }
+    void setSplitDepth(int depth) { splitdepth = depth; }
+
+    bool compile();
+    // stops the search, from any thread; compile() then returns false
+    // unless it has found a solution already
+    void cancel();
+
+    bool findall;
+    long getSolutions() { return solutions; }
+    long getTasks() { return tasks; }
+
+protected:
+    struct Task {
+        std::vector<int> cells;
+        std::vector<Symbol> symbols;
+        std::vector<int> rank;
+    };
+
+    class TaskQueue {
+        std::mutex m;
+        std::deque<Task> q;
+    public:
+        void push(const Task &t);
+        bool pop(Task &t);
+        bool steal(Task &t);
+    };
+
+    struct Worker {
+        TaskQueue queue;
+        Grid work;
+        // the grid as given, every task starts from it
+        Grid::Snapshot start;
+        std::vector<int> rank;
+        std::atomic<bool> cancelled;
+        Worker(const Grid &g) : work(g), start(work.snapshot()), cancelled(false) {}
+    };
+
+    Grid &g;
+    Dict &d;
+    int threads;
+    unsigned int seed;
+    int splitdepth;
+
+    std::vector<Worker*> workers;
+    // queued and running tasks
+    std::atomic<long> pending;
+    std::atomic<long> solutions;
+    std::atomic<long> tasks;
+
+    // idle threads wait for generation to change
+    std::mutex waitlock;
+    std::condition_variable wakeup;
+    long generation;
+    void signal();
+
+    // the best solution so far, guarded by bestlock
+    std::mutex bestlock;
+    std::vector<int> bestrank;
+    Grid *best;
+    // set by cancel() or the first error, also guarded by bestlock
+    bool stopped, failed;
+    std::string failure;
+    void fail(const std::string &msg);
+
+    void run(int no);
+    bool gettask(int no, Task &t);
+    bool starttask(Worker &wk, const Task &t);
+    void expand(Worker &wk, const Task &t);
+    void runleaf(Worker &wk, const Task &t);
+    void found(Worker &wk, const Task &t);
+    unsigned int taskseed(const Task &t);
+};
+
+#endif // CWC_PARALLELCOMPILER_HH
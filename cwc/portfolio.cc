@@ -0,0 +1,113 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <thread>
+
+#include "cwc.hh"
+#include "portfolio.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class portfolio
+
+Portfolio::Portfolio(Grid &thegrid, Dict &thedict)
+    : g(thegrid), d(thedict), threads(0), seed(0), winner(-1), cancelled(false) {
+}
+
+void Portfolio::run(int no, Grid &copy) {
+    Member &m = members[no];
+
+    Walker *w;
+    if (m.walker == prefixwalker)
+        w = new PrefixWalker(copy);
+    else
+        w = new FloodWalker(copy);
+
+    Backtracker *bt;
+    if (m.backtracker == naivebacktracker)
+        bt = new NaiveBacktracker(copy);
+    else if (m.backtracker == conflictbacktracker)
+        bt = new ConflictBacktracker(copy);
+    else
+        bt = new SmartBacktracker(copy);
+
+    Compiler c(copy, *w, *bt, d);
+    c.setSeed(m.seed);
+    c.setCancelFlag(&cancelled);
+
+    try {
+        m.solved = c.compile();
+    } catch (error &) {
+        m.solved = false;
+    }
+
+    if (m.solved) {
+        int none = -1;
+        if (finisher.compare_exchange_strong(none, no))
+            cancelled = true;
+    }
+
+    delete bt;
+    delete w;
+}
+
+bool Portfolio::compile() {
+    int n = threads;
+    if (n <= 0)
+        n = std::thread::hardware_concurrency();
+    if (n <= 0)
+        n = 1;
+
+    // walk through every walker/backtracker combination, flood walking
+    // with smart backtracking first as that is the usual best.
+    static const backtracker_t backtrackers[] = {
+        smartbacktracker, conflictbacktracker, naivebacktracker
+    };
+    members.clear();
+    for (int i = 0; i < n; i++) {
+        Member m;
+        m.walker = (i % 2 == 0) ? floodwalker : prefixwalker;
+        m.backtracker = backtrackers[(i / 2) % 3];
+        m.seed = seed + i * 7919;
+        m.solved = false;
+        members.push_back(m);
+    }
+
+    // the copies are made before any thread starts, so the original
+    // grid is never read concurrently.
+    std::vector<Grid> copies(n, g);
+
+    finisher = -1;
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < n; i++)
+        pool.push_back(std::thread(&Portfolio::run, this, i, std::ref(copies[i])));
+    for (int i = 0; i < n; i++)
+        pool[i].join();
+    // reset only now, so that a cancel() made before is not lost
+    cancelled = false;
+
+    winner = finisher;
+    if (winner < 0)
+        return false;
+
+    g = copies[winner];
+    return true;
+}
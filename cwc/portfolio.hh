@@ -0,0 +1,81 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_PORTFOLIO_HH
+#define CWC_PORTFOLIO_HH
+
+#include <atomic>
+#include <vector>
+
+#include "grid.hh"
+#include "dict.hh"
+
+/**
+ * The portfolio races several independent compilers against each
+ * other, one per thread. Every member works on its own copy of the
+ * grid with its own seed and its own combination of walker and
+ * backtracker. The first member to finish wins and cooperatively
+ * cancels the others; its fill is copied back into the grid.
+ *
+ * The dictionary is shared between all members and must not be
+ * modified while compile() runs.
+ */
+
+class Portfolio {
+public:
+    typedef enum { prefixwalker, floodwalker } walker_t;
+    typedef enum { naivebacktracker, smartbacktracker, conflictbacktracker } backtracker_t;
+
+    struct Member {
+        walker_t walker;
+        backtracker_t backtracker;
+        unsigned int seed;
+        bool solved;
+    };
+
+    Portfolio(Grid &thegrid, Dict &thedict);
+
+    // zero means one member per hardware thread
+    void setThreads(int n) { threads = n; }
+    void setSeed(unsigned int s) { seed = s; }
+
+    bool compile();
+    // stops the members, from any thread; compile() then returns false
+    // unless one of them has finished
+    void cancel() { cancelled = true; }
+
+    int getWinner() { return winner; }
+    const std::vector<Member> &getMembers() { return members; }
+
+protected:
+    Grid &g;
+    Dict &d;
+    int threads;
+    unsigned int seed;
+    int winner;
+    std::vector<Member> members;
+    std::atomic<bool> cancelled;
+    std::atomic<int> finisher;
+
+    void run(int no, Grid &copy);
+};
+
+#endif // CWC_PORTFOLIO_HH
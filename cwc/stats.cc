@@ -0,0 +1,145 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <typeinfo>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "stats.hh"
+#include "dict.hh"
+#include "cachedict.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class SearchStats
+
+SearchStats::SearchStats()
+    : wall(Timer::walltime), cpu(Timer::threadtime), sampleevery(4096) {
+    clear();
+}
+
+void SearchStats::clear() {
+    nodes = backtracks = solutions = 0;
+    domainhits = queries = 0;
+    for (int i = 0; i < jumpbuckets; i++)
+        jumps[i] = 0;
+    for (int i = 0; i <= MAXSYMBOLS; i++)
+        domainsizes[i] = 0;
+    dicts.clear();
+    celldomains.clear();
+    cellvisits.clear();
+    samples.clear();
+    wall.stop();
+    wall.reset();
+    cpu.stop();
+    cpu.reset();
+    windowsum = windowcount = 0;
+    jumpfrom = 0;
+}
+
+void SearchStats::sample(int depth) {
+    Sample s;
+    s.nodes = nodes;
+    s.msecs = wall.getnsecs() / 1e6;
+    s.depth = depth;
+    s.domain = windowcount ? double(windowsum) / windowcount : 0;
+    samples.push_back(s);
+    windowsum = windowcount = 0;
+    if (callback)
+        callback(*this);
+}
+
+void SearchStats::dictquery(Dict &d) {
+    for (size_t i = 0; i < dicts.size(); i++) {
+        if (dicts[i].dict == &d) {
+            // keep the busy one last
+            std::swap(dicts[i], dicts.back());
+            dicts.back().calls++;
+            return;
+        }
+    }
+    DictCalls dc;
+    dc.dict = &d;
+    // mangled names are the class name behind its length
+    dc.name = typeid(d).name();
+    size_t n = 0;
+    while (n < dc.name.size() && isdigit((unsigned char)dc.name[n]))
+        n++;
+    dc.name.erase(0, n);
+    dc.calls = 1;
+    dc.hitsbase = dc.missesbase = 0;
+    if (CacheDict *c = dynamic_cast<CacheDict*>(&d)) {
+        dc.hitsbase = c->getHits();
+        dc.missesbase = c->getMisses();
+    }
+    dicts.push_back(dc);
+}
+
+void SearchStats::writejson(std::ostream &os) const {
+    os << "{\"nodes\": " << nodes << ", \"backtracks\": " << backtracks
+       << ", \"solutions\": " << solutions
+       << ", \"wallmsecs\": " << wall.getnsecs() / 1e6
+       << ", \"cpumsecs\": " << cpu.getnsecs() / 1e6
+       << ", \"domainhits\": " << domainhits << ", \"queries\": " << queries;
+
+    int last = jumpbuckets;
+    while (last > 0 && jumps[last - 1] == 0)
+        last--;
+    os << ",\n \"backjumps\": [";
+    for (int i = 0; i < last; i++)
+        os << (i ? ", " : "") << jumps[i];
+
+    os << "],\n \"dicts\": [";
+    for (size_t i = 0; i < dicts.size(); i++) {
+        os << (i ? ", " : "") << "{\"name\": \"" << dicts[i].name
+           << "\", \"calls\": " << dicts[i].calls;
+        if (CacheDict *c = dynamic_cast<CacheDict*>(dicts[i].dict)) {
+            os << ", \"cachehits\": " << c->getHits() - dicts[i].hitsbase
+               << ", \"cachemisses\": " << c->getMisses() - dicts[i].missesbase;
+        }
+        os << "}";
+    }
+
+    last = MAXSYMBOLS + 1;
+    while (last > 0 && domainsizes[last - 1] == 0)
+        last--;
+    os << "],\n \"domainsizes\": [";
+    for (int i = 0; i < last; i++)
+        os << (i ? ", " : "") << domainsizes[i];
+
+    // cells that were never filled in are left out
+    os << "],\n \"cells\": [";
+    bool first = true;
+    for (size_t i = 0; i < cellvisits.size(); i++) {
+        if (!cellvisits[i])
+            continue;
+        os << (first ? "" : ", ") << "{\"cell\": " << i << ", \"visits\": " << cellvisits[i]
+           << ", \"domain\": " << double(celldomains[i]) / cellvisits[i] << "}";
+        first = false;
+    }
+
+    os << "],\n \"samples\": [";
+    for (size_t i = 0; i < samples.size(); i++) {
+        const Sample &s = samples[i];
+        os << (i ? ", " : "") << "{\"nodes\": " << s.nodes << ", \"msecs\": " << s.msecs
+           << ", \"depth\": " << s.depth << ", \"domain\": " << s.domain << "}";
+    }
+    os << "]}" << std::endl;
+}
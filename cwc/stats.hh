@@ -0,0 +1,138 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_STATS_HH
+#define CWC_STATS_HH
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "symbol.hh"
+#include "timer.hh"
+
+class Dict;
+
+/**
+ * Search statistics. A compiler given a SearchStats counts the nodes
+ * it visits, its dead ends and how far each backtrack jumps, the
+ * domain size of every cell it fills and the dictionary queries the
+ * grid makes (and the ones its domain cache saves), and times itself
+ * in real and thread CPU time. Every sampleevery nodes a sample of
+ * progress is kept and the callback, if any, called.
+ *
+ * The counting is done through CWC_COUNT(stats, call), which is empty
+ * unless cwc is built with CWC_STATS defined, so normal builds pay
+ * nothing for it.
+ */
+
+#ifdef CWC_STATS
+#define CWC_COUNT(stats, call) do { if (stats) (stats)->call; } while (0)
+#else
+#define CWC_COUNT(stats, call) do {} while (0)
+#endif
+
+class SearchStats {
+public:
+    struct DictCalls {
+        Dict *dict;
+        std::string name;
+        long calls;
+        // hit and miss counts of a CacheDict when first seen
+        long hitsbase, missesbase;
+    };
+    struct Sample {
+        long nodes;
+        double msecs;
+        int depth;
+        // mean domain size since the previous sample
+        double domain;
+    };
+    typedef std::function<void(const SearchStats &)> callback_t;
+
+    static const int jumpbuckets = 64;
+
+    long nodes, backtracks, solutions;
+    // cells taken back per backtrack; the last bucket holds the
+    // longer jumps
+    long jumps[jumpbuckets];
+    // findpossible() answers taken from the grid's domain cache, and
+    // the dictionary queries made instead
+    long domainhits, queries;
+    std::vector<DictCalls> dicts;
+    // number of domains of every size, and per cell the sum of its
+    // domain sizes and how often it was filled in
+    long domainsizes[MAXSYMBOLS + 1];
+    std::vector<long> celldomains, cellvisits;
+    std::vector<Sample> samples;
+    Timer wall, cpu;
+
+    long sampleevery;
+    callback_t callback;
+
+    SearchStats();
+    void clear();
+
+    void start() { wall.start(); cpu.start(); }
+    void stop() { wall.stop(); cpu.stop(); }
+
+    void node(int depth) {
+        if (++nodes % sampleevery == 0)
+            sample(depth);
+    }
+    void domain(int cno, int size) {
+        if (cno >= int(cellvisits.size())) {
+            celldomains.resize(cno + 1, 0);
+            cellvisits.resize(cno + 1, 0);
+        }
+        celldomains[cno] += size;
+        cellvisits[cno]++;
+        domainsizes[size]++;
+        windowsum += size;
+        windowcount++;
+    }
+    // a dead end at depth, and the depth the backtracker went back to
+    void backtrack(int depth) { backtracks++; jumpfrom = depth; }
+    void backjump(int depth) {
+        int d = jumpfrom - depth;
+        jumps[d < jumpbuckets ? (d < 0 ? 0 : d) : jumpbuckets - 1]++;
+    }
+    void solution() { solutions++; }
+    void domainhit() { domainhits++; }
+    void query(Dict &d) {
+        queries++;
+        if (!dicts.empty() && dicts.back().dict == &d)
+            dicts.back().calls++;
+        else
+            dictquery(d);
+    }
+
+    void writejson(std::ostream &os) const;
+
+private:
+    long windowsum, windowcount;
+    int jumpfrom;
+    void sample(int depth);
+    void dictquery(Dict &d);
+};
+
+#endif // CWC_STATS_HH
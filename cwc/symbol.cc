@@ -25,67 +25,118 @@
 
 #include <stdlib.h>
 
+// the character and its code, for error messages
+static std::string describe(char ch) {
+    return "'" + std::string(1, ch) + "' (" + std::to_string(int((unsigned char)ch)) + ")";
+}
+
 //////////////////////////////////////////////////////////////////////
-// class symbol
+// class AsciiAlphabet
 
-char Symbol::alphabet[32];
-Symbol Symbol::alphindex[256];
+constexpr AsciiTable AsciiAlphabet::table;
 
-int Symbol::symballoc = 0;
-Symbol Symbol::outside;
-Symbol Symbol::none;
-Symbol Symbol::empty;
+int AsciiAlphabet::alloc(char ch) {
+    throw error("Symbol " + describe(ch) + " outside the alphabet");
+}
 
-Symbol Symbol::symbolbit(SymbolSet ss) {
-    Symbol s;
-    for (SymbolSet i=1,n=0; i; i<<=1,n++) {
-        if (ss&i)
-            s.symb = n;
-    }
-    return s;
+//////////////////////////////////////////////////////////////////////
+// class WideAlphabet
+
+std::atomic<unsigned char> WideAlphabet::indices[256];
+char WideAlphabet::letters[64];
+std::atomic<int> WideAlphabet::used(0);
+std::mutex WideAlphabet::lock;
+
+// called with the lock held
+int WideAlphabet::add(char ch) {
+    int n = used.load(std::memory_order_relaxed);
+    if (n >= size)
+        throw error("Too many symbols for " + describe(ch) + ", have \""
+                    + std::string(letters, n) + "\"");
+    letters[n] = ch;
+    used.store(n + 1, std::memory_order_release);
+    indices[(unsigned char)ch].store(n + 1, std::memory_order_release);
+    return n;
 }
 
-Symbol Symbol::alloc(char ch) {
-    Symbol s;
-    if (symballoc >= 32) {
-        for (int i=0; i<32;i++) std::cout << alphabet[i];
-        std::cout << std::endl;
-        std::cout << ch << ' ' << int(ch) << std::endl;
-        throw error("Too many symbols");
+int WideAlphabet::alloc(char ch) {
+    std::lock_guard<std::mutex> l(lock);
+    // the special symbols come first even without a reset()
+    if (used.load(std::memory_order_relaxed) == 0) {
+        add('/');
+        add('+');
+        add(' ');
     }
+    // someone else may have been first
+    int n = index(ch);
+    return n != UNDEF ? n : add(ch);
+}
+
+void WideAlphabet::reset() {
+    std::lock_guard<std::mutex> l(lock);
+    for (int i=0; i<256; i++)
+        indices[i].store(0, std::memory_order_relaxed);
+    used.store(0, std::memory_order_release);
+    add('/');
+    add('+');
+    add(' ');
+}
+
+//////////////////////////////////////////////////////////////////////
+// class symbol
 
-    s.symb = symballoc;
-    symballoc++;
-    alphabet[(int)s.symb] = ch;
-    alphindex[(unsigned char)ch].symb = s.symb;
+Symbol Symbol::none('/');
+Symbol Symbol::empty('+');
+Symbol Symbol::outside(' ');
+
+Symbol Symbol::symbolbit(SymbolSet ss) {
+    Symbol s;
+    if (ss)
+        s.symb = firstbit(ss);
     return s;
 }
 
 void Symbol::buildindex() {
-    for (int i=0;i<32;i++)
-        alphabet[i] = UNDEF;
-    for (int i=0;i<256;i++)
-        alphindex[i].symb = UNDEF;
-    symballoc = 0;
-    none = Symbol::alloc('/');
-    empty = Symbol::alloc('+');
-    outside = Symbol::alloc(' ');
+    Alphabet::reset();
+    none = Symbol('/');
+    empty = Symbol('+');
+    outside = Symbol(' ');
 }
 
-Symbol::Symbol(char ch) {
-    symb = alphindex[(unsigned char)ch].symb;
-    if (symb == UNDEF)
-        *this = Symbol::alloc(ch);
+static SymbolSet pickbitwith(SymbolSet &ss, int r) {
+    int n = numones(ss);
+    if (n==0) return 0;
+    SymbolSet m = ss;
+    for (int i = r % n; i; i--)
+        m &= m - 1;
+    SymbolSet bit = m & -m;
+    ss &= ~bit;
+    return bit;
 }
 
 SymbolSet pickbit(SymbolSet &ss) {
-    int a[32], n = 0;
-    for (int i=1; i; i<<=1) {
-        if (ss & i)
-            a[n++] = i;
+    return pickbitwith(ss, rand());
+}
+
+// reentrant version for compilers running in parallel, each one
+// carrying its own random state.
+SymbolSet pickbit(SymbolSet &ss, unsigned int *seed) {
+    return pickbitwith(ss, rand_r(seed));
+}
+
+SymbolSet pickbest(SymbolSet &ss, const int *score, unsigned int *seed) {
+    if (!ss) return 0;
+    SymbolSet top = 0;
+    int topscore = 0;
+    for (SymbolSet m = ss; m; m &= m - 1) {
+        int sc = score[firstbit(m)];
+        if (!top || sc > topscore) {
+            top = m & -m;
+            topscore = sc;
+        } else if (sc == topscore)
+            top |= m & -m;
     }
-    if (n==0) return 0;
-    SymbolSet bit = a[rand()%n];
+    SymbolSet bit = pickbitwith(top, rand_r(seed));
     ss &= ~bit;
     return bit;
 }
@@ -104,19 +155,10 @@ std::ostream &operator <<(std::ostream &os, Symbol *s) {
     return os;
 }
 
-int numones(SymbolSet ss) {
-    int n = 0;
-    for (int i=1; i; i <<= 1) {
-        if (ss&i)
-            n++;
-    }
-    return n;
-}
-
 int Symbol::numalpha() {
     int n = 0;
-    for (int i=0; i<32; i++)
-        if (isalpha(alphabet[i]))
+    for (int i=0; i<MAXSYMBOLS; i++)
+        if (isletter(letter(i)))
             n++;
     return n;
 }
@@ -23,25 +23,24 @@
 #define CWC_SYMBOL_HH
 
 #include "main.hh"
+#include "alphabet.hh"
 
-typedef unsigned long SymbolSet;
+typedef Alphabet::set_type SymbolSet;
 
-#define UNDEF 0x7f
+// number of symbol values, and so of bits in a SymbolSet
+const int MAXSYMBOLS = Alphabet::size;
 
 class Symbol {
     char symb;
-    static Symbol alphindex[256];
-    static char searchchar(char);
-    static int symballoc;
 public:
-    static char alphabet[32];
     static Symbol outside, empty, none;
-    static Symbol alloc(char ch = UNDEF);
     static Symbol symbolbit(SymbolSet); // named constructor
-    //  static symbol special();
 
     Symbol() : symb(UNDEF) {}
-    Symbol(char ch);
+    Symbol(char ch) : symb(Alphabet::index(ch)) {
+        if (symb == UNDEF)
+            symb = Alphabet::alloc(ch);
+    }
 
     inline SymbolSet getsymbolset();
     inline operator char();
@@ -49,11 +48,14 @@ public:
 
     static void buildindex();
     int symbvalue() { return int(symb); }
+    static char letter(int n) { return Alphabet::letter(n); }
+    static bool isletter(char ch) { return Alphabet::isletter(ch); }
     static int numalpha();
+    static int numsymbols() { return Alphabet::count(); }
 };
 
 SymbolSet Symbol::getsymbolset() {
-    return 1 << symb;
+    return SymbolSet(1) << symb;
 }
 
 bool Symbol::operator==(Symbol const &s) const {
@@ -62,19 +64,25 @@ bool Symbol::operator==(Symbol const &s) const {
 
 Symbol::operator char() {
     if (symb == UNDEF) throw error("action on undefined symbol");
-    return alphabet[(int)symb];
+    return Alphabet::letter(symb);
 }
 
 SymbolSet pickbit(SymbolSet &ss);
+SymbolSet pickbit(SymbolSet &ss, unsigned int *seed);
+// as pickbit(), among the symbols of ss with the highest score[symbol value]
+SymbolSet pickbest(SymbolSet &ss, const int *score, unsigned int *seed);
 
 //////////////////////////////////////////////////////////////////////
 
 void dumpset(SymbolSet ss);
+std::string setstring(SymbolSet ss);
 void dumpsymbollist(Symbol *s, int n);
 std::ostream &operator <<(std::ostream &os, Symbol *s);
 
 int wordlen(Symbol *st);
 
-int numones(SymbolSet ss);
+inline int numones(SymbolSet ss) {
+    return popcount(ss);
+}
 
 #endif // CWC_SYMBOL_HH
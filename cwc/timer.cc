@@ -19,46 +19,47 @@
  * 02111-1307, USA.
  **/
 
-#include <sys/times.h>
 #include <time.h>
 #include "timer.hh"
 
-Timer::Timer() : elapsed(0), starttime(0), running(false) {
+Timer::Timer(clock_type t) : type(t), elapsed(0), starttime(0), running(false) {
 }
 
-clock_t Timer::getptime() {
-    struct tms t;
-    times(&t);
-    return t.tms_utime;
+int64_t Timer::now() const {
+    static const clockid_t clocks[] = {
+        CLOCK_PROCESS_CPUTIME_ID, CLOCK_MONOTONIC, CLOCK_THREAD_CPUTIME_ID
+    };
+    struct timespec ts;
+    clock_gettime(clocks[type], &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
 }
 
 void Timer::start() {
     if (running)
         return;
-    starttime = getptime();
+    starttime = now();
     running = true;
 }
 
 void Timer::stop() {
     if (!running)
         return;
-    clock_t stop_time = getptime();
-    elapsed += stop_time - starttime;
+    elapsed += now() - starttime;
     running = false;
 }
 
 void Timer::reset() {
     elapsed = 0;
-    starttime = getptime();
+    starttime = now();
 }
 
-clock_t Timer::getticks() {
-    clock_t t = elapsed;
+int64_t Timer::getnsecs() const {
+    int64_t t = elapsed;
     if (running)
-        t += getptime() - starttime;
+        t += now() - starttime;
     return t;
 }
 
-int Timer::getmsecs() {
-    return (getticks() * 1000) / CLOCKS_PER_SEC;
+int Timer::getmsecs() const {
+    return getnsecs() / 1000000;
 }
@@ -22,25 +22,32 @@
 #ifndef CWC_TIMER_HH
 #define CWC_TIMER_HH
 
-#include <sys/times.h>
+#include <stdint.h>
 
 /**
- * The timer module implement a simple stop-watch time
- * measuring process time (not real time).
+ * The timer module implement a simple stop-watch. By default it
+ * measures process time (not real time); it can also measure
+ * monotonic real time or the CPU time of the calling thread, which
+ * must then start and stop it.
  */
 
 class Timer {
+public:
+    typedef enum { processtime, walltime, threadtime } clock_type;
 protected:
-    clock_t elapsed, starttime;
+    clock_type type;
+    // nanoseconds
+    int64_t elapsed, starttime;
     bool running;
-    clock_t getptime();
+    int64_t now() const;
 public:
-    clock_t getticks();
-    Timer();
+    Timer(clock_type t = processtime);
     void start();
     void stop();
     void reset();
-    int getmsecs();
+    int64_t getnsecs() const;
+    double getusecs() const { return getnsecs() / 1e3; }
+    int getmsecs() const;
 };
 
 #endif // CWC_TIMER_HH
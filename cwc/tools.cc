@@ -0,0 +1,232 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <set>
+#include <chrono>
+#include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "tools.hh"
+#include "letterdict.hh"
+#include "bitmapdict.hh"
+#include "dawgdict.hh"
+#include "cachedict.hh"
+#include "mmapdict.hh"
+#include "trace.hh"
+
+//////////////////////////////////////////////////////////////////////
+// options and patterns
+
+std::vector<std::string> splitlist(const std::string &str) {
+    std::vector<std::string> parts;
+    std::stringstream ss(str);
+    std::string part;
+    while (std::getline(ss, part, ','))
+        if (!part.empty())
+            parts.push_back(part);
+    return parts;
+}
+
+void addpatterns(const std::string &path, std::vector<std::string> &files) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        throw error("No such pattern: " + path);
+    if (!S_ISDIR(st.st_mode)) {
+        files.push_back(path);
+        return;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (!dir)
+        throw error("Failed to read directory " + path);
+    std::vector<std::string> names;
+    while (struct dirent *e = readdir(dir)) {
+        if (e->d_name[0] != '.')
+            names.push_back(e->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    for (size_t i = 0; i < names.size(); i++)
+        files.push_back(path + "/" + names[i]);
+}
+
+std::string patternname(const std::string &path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// only grid templates, which start with their dimensions
+bool loadpattern(const std::string &fn, Grid &g) {
+    std::ifstream f(fn.c_str());
+    std::string first;
+    int w = 0, h = 0;
+    if (!f.is_open() || !std::getline(f, first) ||
+        sscanf(first.c_str(), "%d %d", &w, &h) != 2 || w < 1 || h < 1)
+        return false;
+    f.seekg(0);
+    g.load_template(f);
+    return g.numopen() > 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// compiler parts
+
+Dict *makedict(const std::string &name, const std::string &wordfile,
+               const std::string &indexfile, std::vector<Dict*> &owned,
+               int minscore) {
+    Dict *d = 0;
+    if (name == "letter") {
+        d = new LetterDict();
+    } else if (name == "bitmap") {
+        d = new BitmapDict();
+    } else if (name == "dawg") {
+        d = new DawgDict();
+    } else if (name == "btree") {
+        d = new BtreeDict();
+    } else if (name == "cache") {
+        // loaded through the cache, along with it
+        Dict *inner = new LetterDict();
+        owned.push_back(inner);
+        d = new CacheDict(*inner);
+    } else if (name == "mmap") {
+        if (indexfile.empty())
+            throw error("The mmap dictionary needs -index");
+        d = new MmapDict();
+        d->load(indexfile);
+        owned.push_back(d);
+        return d;
+    } else {
+        throw error("Unknown dictionary " + name);
+    }
+    d->minscore = minscore;
+    d->load(wordfile);
+    owned.push_back(d);
+    return d;
+}
+
+Walker *makewalker(const std::string &name, Grid &g) {
+    if (name == "prefix")
+        return new PrefixWalker(g);
+    if (name == "flood")
+        return new FloodWalker(g);
+    if (name == "hub")
+        return new HubWalker(g);
+    throw error("Unknown walker " + name);
+}
+
+Backtracker *makebacktracker(const std::string &name, Grid &g) {
+    if (name == "naive")
+        return new NaiveBacktracker(g);
+    if (name == "smart")
+        return new SmartBacktracker(g);
+    if (name == "conflict")
+        return new ConflictBacktracker(g);
+    throw error("Unknown backtracker " + name);
+}
+
+std::string checkfill(Grid &g, Dict &d, bool nodupes) {
+    std::set<std::string> seen;
+    for (int s = 0; s < g.numslots(); s++) {
+        int len = g.slotlength(s);
+        if (len < 2)
+            continue;
+        if (len > MAXWORDLEN)
+            return "Slot " + std::to_string(s) + " is too long";
+        Symbol word[MAXWORDLEN + 1];
+        std::string str;
+        for (int p = 0; p < len; p++) {
+            word[p] = g(g.slotcell(s, p)).getsymbol();
+            if (word[p] == Symbol::empty || word[p] == Symbol::outside)
+                return "Slot " + std::to_string(s) + " is not filled";
+            str += char(word[p]);
+        }
+        word[len] = Symbol::outside;
+
+        // any dictionary can tell whether the first letter may go
+        // with the rest
+        Symbol first = word[0];
+        word[0] = Symbol::empty;
+        if (!(d.findpossible(word, len, 0) & first.getsymbolset()))
+            return "\"" + str + "\" is not in the dictionary";
+        if (nodupes && !seen.insert(str).second)
+            return "\"" + str + "\" is used twice";
+    }
+    return "";
+}
+
+//////////////////////////////////////////////////////////////////////
+// output
+
+std::string jsonquote(const std::string &str) {
+    std::string q = "\"";
+    for (size_t i = 0; i < str.size(); i++) {
+        unsigned char ch = str[i];
+        if (ch == '"' || ch == '\\') {
+            q += '\\';
+            q += ch;
+        } else if (ch < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            q += buf;
+        } else {
+            q += ch;
+        }
+    }
+    return q + "\"";
+}
+
+void dumptrace(const std::string &fn) {
+    if (!CWC_TRACING)
+        std::cerr << "Traces are compiled out of this build (NDEBUG)" << std::endl;
+    std::ofstream f(fn.c_str());
+    if (!f.is_open()) {
+        std::cerr << "Failed to create " << fn << std::endl;
+        return;
+    }
+    Trace::dump(f);
+}
+
+//////////////////////////////////////////////////////////////////////
+// class deadline
+
+Deadline::Deadline(long msecs, std::function<void()> stop) : done(false) {
+    if (msecs > 0)
+        timer = std::thread(&Deadline::wait, this, msecs, stop);
+}
+
+Deadline::~Deadline() {
+    {
+        std::lock_guard<std::mutex> l(m);
+        done = true;
+    }
+    cv.notify_all();
+    if (timer.joinable())
+        timer.join();
+}
+
+void Deadline::wait(long msecs, std::function<void()> stop) {
+    std::unique_lock<std::mutex> l(m);
+    if (!cv.wait_for(l, std::chrono::milliseconds(msecs), [this] { return done; }))
+        stop();
+}
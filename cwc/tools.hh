@@ -0,0 +1,91 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_TOOLS_HH
+#define CWC_TOOLS_HH
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <limits.h>
+
+#include "cwc.hh"
+
+/**
+ * Helpers shared by the command line tools (bench, generate): finding
+ * and loading patterns and making the parts of a compiler by name.
+ */
+
+// splits a comma separated list
+std::vector<std::string> splitlist(const std::string &str);
+
+// adds path to files, or every file in it if it is a directory
+void addpatterns(const std::string &path, std::vector<std::string> &files);
+std::string patternname(const std::string &path);
+// loads a grid template; false if fn is none or has no open cells
+bool loadpattern(const std::string &fn, Grid &g);
+
+// letter, bitmap, dawg, btree, cache (over letter) or mmap. Every
+// dictionary made is added to owned, to be deleted by the caller.
+// Words of a scored list below minscore are left out (not by mmap);
+// by default none are.
+Dict *makedict(const std::string &name, const std::string &wordfile,
+               const std::string &indexfile, std::vector<Dict*> &owned,
+               int minscore = INT_MIN);
+// prefix, flood or hub
+Walker *makewalker(const std::string &name, Grid &g);
+// naive, smart or conflict
+Backtracker *makebacktracker(const std::string &name, Grid &g);
+
+// checks a fill: every word of two or more cells must be complete and
+// in d, and with nodupes no word may be used twice. Returns what is
+// wrong, or "" for a good fill.
+std::string checkfill(Grid &g, Dict &d, bool nodupes);
+
+// str as a JSON string
+std::string jsonquote(const std::string &str);
+
+// writes the trace buffer to fn, see trace.hh. Says so on stderr when
+// the build records no traces.
+void dumptrace(const std::string &fn);
+
+/**
+ * calls stop once msecs have passed, from a thread of its own, unless
+ * it is destroyed first. For the compilers that can be cancelled but
+ * have no time budget. Never calls stop when msecs is 0.
+ */
+class Deadline {
+public:
+    Deadline(long msecs, std::function<void()> stop);
+    ~Deadline();
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    bool done;
+    std::thread timer;
+    void wait(long msecs, std::function<void()> stop);
+};
+
+#endif // CWC_TOOLS_HH
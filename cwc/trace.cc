@@ -0,0 +1,77 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <string.h>
+#include <algorithm>
+
+#include "trace.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class Trace
+//
+// Every writer claims a message number and with it a slot, and marks
+// the slot busy while copying. A reader copies a slot and keeps the
+// copy only if the slot held the same message before and after.
+
+Trace::Entry Trace::ring[Trace::entries];
+std::atomic<uint64_t> Trace::head(0);
+
+void Trace::record(int category, int level, const std::string &text) {
+    uint64_t n = head.fetch_add(1, std::memory_order_relaxed);
+    Entry &e = ring[n % entries];
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.category = category;
+    e.level = level;
+    size_t len = std::min(text.size(), size_t(textsize - 1));
+    memcpy(e.text, text.data(), len);
+    e.text[len] = '\0';
+    e.seq.store(n + 1, std::memory_order_release);
+}
+
+void Trace::dump(std::ostream &os) {
+    static const char *names[] = { "walker", "backtracker", "dict", "compiler" };
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = end > uint64_t(entries) ? end - entries : 0;
+    for (uint64_t n = begin; n < end; n++) {
+        Entry &e = ring[n % entries];
+        if (e.seq.load(std::memory_order_acquire) != n + 1)
+            continue;
+        unsigned char category = e.category, level = e.level;
+        char text[textsize];
+        memcpy(text, e.text, textsize);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != n + 1)
+            continue;
+        text[textsize - 1] = '\0';
+
+        const char *name = "?";
+        for (int i = 0; i < 4; i++)
+            if (category == (1 << i))
+                name = names[i];
+        os << n << ' ' << name << ' ' << int(level) << ' ' << text << std::endl;
+    }
+}
+
+void Trace::clear() {
+    for (int i = 0; i < entries; i++)
+        ring[i].seq.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,108 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_TRACE_HH
+#define CWC_TRACE_HH
+
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+
+/**
+ * Trace logging for the search. CWC_TRACE(category, level, message)
+ * records the message, anything that can be written to an ostream
+ * joined with <<, when its category is in CWC_TRACE_CATEGORIES and
+ * its level is at most CWC_TRACE_LEVEL. Both are compile-time
+ * constants, so traces that are off cost nothing, and with NDEBUG or
+ * QT_NO_DEBUG defined tracing compiles out completely.
+ *
+ * Messages go to a fixed size ring buffer, which any thread may write
+ * to without locking; the oldest messages are overwritten. dump()
+ * writes out what the buffer holds.
+ */
+
+enum TraceCategory {
+    trace_walker = 1,
+    trace_backtracker = 2,
+    trace_dict = 4,
+    trace_compiler = 8
+};
+
+enum TraceLevel {
+    trace_info = 1,
+    trace_debug = 2,
+    // every step of the innermost loops
+    trace_verbose = 3
+};
+
+#ifndef CWC_TRACE_CATEGORIES
+#define CWC_TRACE_CATEGORIES (trace_walker | trace_backtracker | trace_dict | trace_compiler)
+#endif
+
+// per node traces slow the search down several times, so they have
+// to be asked for
+#ifndef CWC_TRACE_LEVEL
+#define CWC_TRACE_LEVEL trace_info
+#endif
+
+#if defined(NDEBUG) || defined(QT_NO_DEBUG)
+#define CWC_TRACING 0
+// still type checked, so release builds don't see unused variables
+#define CWC_TRACE(category, level, message) do {                        \
+        if (false) {                                                      \
+            std::ostringstream tracemsg;                                  \
+            tracemsg << message;                                          \
+        }                                                                 \
+    } while (0)
+#else
+#define CWC_TRACING 1
+#define CWC_TRACE(category, level, message) do {                        \
+        if (((category) & (CWC_TRACE_CATEGORIES)) && (level) <= (CWC_TRACE_LEVEL)) { \
+            std::ostringstream tracemsg;                                  \
+            tracemsg << message;                                          \
+            Trace::record(category, level, tracemsg.str());               \
+        }                                                                 \
+    } while (0)
+#endif
+
+class Trace {
+public:
+    static const int entries = 4096;
+    static const int textsize = 116;
+
+    static void record(int category, int level, const std::string &text);
+    // oldest first. Messages written meanwhile may be left out.
+    static void dump(std::ostream &os);
+    static void clear();
+
+private:
+    struct Entry {
+        // number of the message + 1, 0 while being written
+        std::atomic<uint64_t> seq;
+        unsigned char category, level;
+        char text[textsize];
+    };
+    static Entry ring[entries];
+    static std::atomic<uint64_t> head;
+};
+
+#endif // CWC_TRACE_HH
@@ -0,0 +1,213 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#include <stdlib.h>
+#include <string>
+
+#include "wordfill.hh"
+
+//////////////////////////////////////////////////////////////////////
+// class wordfiller
+
+WordFiller::WordFiller(Grid &thegrid, WordList &thewords)
+    : unique(true), g(thegrid), wl(thewords), seed(rand()), cancelflag(0),
+      nodes(0) {
+}
+
+bool WordFiller::fits(int word, const Slot &s) {
+    Symbol *w = wl[word];
+    int len = s.cells.size();
+    for (int p = 0; p < len; p++) {
+        Symbol cs = g(s.cells[p]).getsymbol();
+        if (!(cs == Symbol::empty) && !(cs == w[p]))
+            return false;
+    }
+    return true;
+}
+
+void WordFiller::setup() {
+    slots.clear();
+    trail.clear();
+    used.assign(wl.numwords(), false);
+
+    // grid slot number to filler slot number, -1 for skipped ones
+    int nblocks = g.numslots();
+    std::vector<int> slotno(nblocks, -1);
+    for (int i = 0; i < nblocks; i++) {
+        int len = g.slotlength(i);
+        if (len < 2)
+            continue;
+        // no word could fill it, and fill_singles() would make one up
+        if (len >= MAXWORDLEN)
+            throw error("Slot of " + std::to_string(len) + " cells is too long for the word filler");
+        Slot s;
+        for (int p = 0; p < len; p++)
+            s.cells.push_back(g.slotcell(i, p));
+        s.word = -1;
+        slotno[i] = slots.size();
+        slots.push_back(s);
+    }
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        Slot &s = slots[i];
+        for (size_t p = 0; p < s.cells.size(); p++) {
+            int cno = s.cells[p];
+            for (int w = 0; w < g.numcellslots(cno); w++) {
+                int o = slotno[g.cellslot(cno, w)];
+                if (o == -1 || o == int(i))
+                    continue;
+                Crossing cr = { int(p), o, g.cellpos(cno, w) };
+                s.crossings.push_back(cr);
+            }
+        }
+    }
+
+    std::vector<int> bylen[MAXWORDLEN];
+    for (size_t i = 0; i < slots.size(); i++)
+        bylen[slots[i].cells.size()].push_back(i);
+
+    int nwords = wl.numwords();
+    for (int w = 0; w < nwords; w++) {
+        int len = wordlen(wl[w]);
+        if (len >= MAXWORDLEN)
+            continue;
+        for (size_t i = 0; i < bylen[len].size(); i++) {
+            Slot &s = slots[bylen[len][i]];
+            if (fits(w, s))
+                s.candidates.push_back(w);
+        }
+    }
+}
+
+void WordFiller::order(int /*slot*/, std::vector<int> &words) {
+    for (int i = words.size() - 1; i > 0; i--)
+        std::swap(words[i], words[rand_r(&seed) % (i + 1)]);
+}
+
+/**
+ * writes word into slot and filters the crossing slots. Returns false
+ * if a crossing slot has no candidates left. The cells are written
+ * through the grid trail.
+ */
+bool WordFiller::place(int slot, int word) {
+    Slot &s = slots[slot];
+    Symbol *w = wl[word];
+
+    s.word = word;
+    used[word] = true;
+    for (size_t p = 0; p < s.cells.size(); p++) {
+        if (g(s.cells[p]).isempty())
+            g.setsymbol(s.cells[p], w[p]);
+    }
+
+    for (size_t i = 0; i < s.crossings.size(); i++) {
+        const Crossing &cr = s.crossings[i];
+        Slot &o = slots[cr.slot];
+        if (o.word >= 0)
+            continue;
+
+        Symbol sym = w[cr.pos];
+        std::vector<int> kept;
+        for (size_t k = 0; k < o.candidates.size(); k++) {
+            if (wl[o.candidates[k]][cr.otherpos] == sym)
+                kept.push_back(o.candidates[k]);
+        }
+        if (kept.size() == o.candidates.size())
+            continue;
+
+        TrailEntry te;
+        te.slot = cr.slot;
+        te.candidates.swap(o.candidates);
+        trail.push_back(te);
+        o.candidates.swap(kept);
+        if (o.candidates.empty())
+            return false;
+    }
+    return true;
+}
+
+void WordFiller::undo(size_t mark, size_t gridmark) {
+    while (trail.size() > mark) {
+        slots[trail.back().slot].candidates.swap(trail.back().candidates);
+        trail.pop_back();
+    }
+    g.rollback(gridmark);
+}
+
+bool WordFiller::fill_rest() {
+    if (cancelflag && cancelflag->load(std::memory_order_relaxed))
+        return false;
+    nodes++;
+
+    // minimum remaining values
+    int best = -1;
+    size_t nbest = 0;
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].word >= 0)
+            continue;
+        if (best < 0 || slots[i].candidates.size() < nbest) {
+            best = i;
+            nbest = slots[i].candidates.size();
+        }
+    }
+    if (best < 0)
+        return true;
+
+    std::vector<int> words = slots[best].candidates;
+    order(best, words);
+
+    for (size_t i = 0; i < words.size(); i++) {
+        int word = words[i];
+        if (unique && used[word])
+            continue;
+
+        size_t mark = trail.size(), gridmark = g.mark();
+        if (place(best, word) && fill_rest())
+            return true;
+        undo(mark, gridmark);
+        slots[best].word = -1;
+        used[word] = false;
+
+        if (cancelflag && cancelflag->load(std::memory_order_relaxed))
+            return false;
+    }
+    return false;
+}
+
+// cells that are not part of any real word get an arbitrary letter
+void WordFiller::fill_singles() {
+    int ncells = g.numcells();
+    for (int i = 0; i < ncells; i++) {
+        if (!g(i).isempty())
+            continue;
+        SymbolSet ss = wl.allalpha;
+        g(i).setsymbol(Symbol::symbolbit(pickbit(ss, &seed)));
+    }
+}
+
+bool WordFiller::fill() {
+    nodes = 0;
+    setup();
+    if (!fill_rest())
+        return false;
+    fill_singles();
+    return true;
+}
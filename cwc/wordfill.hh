@@ -0,0 +1,105 @@
+/**
+ * cwc - a crossword compiler.
+ *
+ * Copyright (C) 1999, 2000, 2001, 2002 Lars Christensen, 2008 Mark Longair
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **/
+
+#ifndef CWC_WORDFILL_HH
+#define CWC_WORDFILL_HH
+
+#include <atomic>
+#include <vector>
+
+#include "grid.hh"
+#include "wordlist.hh"
+
+/**
+ * The word filler is an alternative to the letter by letter Compiler.
+ * It assigns whole words from a word list to the word blocks (slots)
+ * of the grid.
+ *
+ * Every open slot keeps the list of words still fitting its cells.
+ * The slot with the fewest candidates is filled next (minimum
+ * remaining values), and each word placed filters the candidates of
+ * the slots crossing it. A slot running out of candidates fails the
+ * word immediately. Candidate lists are restored from a trail on
+ * backtracking.
+ *
+ * Slots of a single cell are not filled as words; any letter allowed
+ * by its crossing slot will do. fill() throws an error if a slot is
+ * MAXWORDLEN cells or longer.
+ */
+
+class WordFiller {
+public:
+    WordFiller(Grid &thegrid, WordList &thewords);
+    virtual ~WordFiller() {}
+
+    bool fill();
+
+    // don't use the same word twice in one fill
+    bool unique;
+
+    void setSeed(unsigned int s) { seed = s; }
+    void setCancelFlag(std::atomic<bool> *flag) { cancelflag = flag; }
+    long getNodes() { return nodes; }
+
+protected:
+    struct Crossing {
+        int pos;      // position in this slot
+        int slot;     // the crossing slot
+        int otherpos; // position in the crossing slot
+    };
+
+    struct Slot {
+        std::vector<int> cells;
+        std::vector<Crossing> crossings;
+        std::vector<int> candidates;
+        int word; // assigned word or -1
+    };
+
+    struct TrailEntry {
+        int slot;
+        std::vector<int> candidates;
+    };
+
+    Grid &g;
+    WordList &wl;
+    unsigned int seed;
+    std::atomic<bool> *cancelflag;
+    long nodes;
+
+    std::vector<Slot> slots;
+    std::vector<TrailEntry> trail;
+    std::vector<bool> used;
+
+    /**
+     * decides in which order the candidates of a slot are tried. The
+     * default shuffles them; override for scoring.
+     */
+    virtual void order(int slot, std::vector<int> &words);
+
+    void setup();
+    bool fits(int word, const Slot &s);
+    bool place(int slot, int word);
+    void undo(size_t mark, size_t gridmark);
+    bool fill_rest();
+    void fill_singles();
+};
+
+#endif // CWC_WORDFILL_HH
@@ -20,35 +20,81 @@
  **/
 
 #include <fstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <limits.h>
 #include "wordlist.hh"
 
 WordList::WordList() {
     allalpha = 0;
+    minscore = INT_MIN;
+    scored = false;
 }
 
 
 bool WordList::wordok(const std::string &fn) {
     int n = fn.length();
     for (int i=0;i<n;i++)
-        if (!isalpha(fn[i]))
+        if (!Symbol::isletter(fn[i]))
             return false;
     return true;
 }
 
+bool WordList::parseline(const std::string &line, std::string &word, int &score) {
+    size_t end = line.find_first_of("; \t\r");
+    word = line.substr(0, end);
+    score = 0;
+    if (end == std::string::npos)
+        return true;
+    size_t start = line.find_first_not_of("; \t\r", end);
+    if (start == std::string::npos)
+        return true;
+    char *rest;
+    long l = strtol(line.c_str() + start, &rest, 10);
+    if (rest == line.c_str() + start || line.find_first_not_of(" \t\r", rest - line.c_str()) != std::string::npos)
+        return false;
+    score = int(l);
+    return true;
+}
+
 void WordList::load(const std::string &fn) {
     std::ifstream f(fn.c_str());
     if (!f.is_open()) throw error("Failed to open file");
 
     widx.clear();
+    scores.clear();
+    index.clear();
 
-    std::string line;
+    std::string line, word;
+    int score;
     while (!f.eof()) {
         std::getline(f, line);
-        addWord(line);
+        if (!parseline(line, word, score) || score < minscore)
+            continue;
+        if (score != 0)
+            scored = true;
+        addWord(word, score);
+    }
+
+    // renumber best first
+    std::vector<int> order(widx.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return scores[a] > scores[b];
+    });
+    std::vector<Symbol*> oldidx(widx);
+    std::vector<int> oldscores(scores), newnumber(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        widx[i] = oldidx[order[i]];
+        scores[i] = oldscores[order[i]];
+        newnumber[order[i]] = i;
     }
+    for (std::unordered_map<std::string, int>::iterator i = index.begin(); i != index.end(); i++)
+        i->second = newnumber[i->second];
 }
 
-void WordList::addWord(const std::string &word)
+void WordList::addWord(const std::string &word, int score)
 {
     if (!chunk) {
         chunk = new Symbol[chunksize];
@@ -64,6 +110,12 @@ void WordList::addWord(const std::string &word)
         return;
     }
 
+    std::string key(word);
+    for (int i=0; i<wordLength; i++)
+        key[i] = tolower((unsigned char)key[i]);
+    if (!index.insert(std::make_pair(key, int(widx.size()))).second)
+        return;
+
     if (chunksize - chunkused < wordLength+1) {
         chunk = new Symbol[chunksize];
         chunkused = 0;
@@ -71,11 +123,22 @@ void WordList::addWord(const std::string &word)
 
     Symbol *addr = chunk + chunkused;
     for (int i=0; i<wordLength; i++) {
-        Symbol s = Symbol(tolower(word[i]));
+        Symbol s = Symbol(key[i]);
         chunk[chunkused++] = s;
         allalpha |= s.getsymbolset();
     }
     chunk[chunkused++] = Symbol::outside;
 
     widx.push_back(addr);
+    scores.push_back(score);
+}
+
+int WordList::find(Symbol *word, int len) {
+    std::string key(len, ' ');
+    for (int i=0; i<len; i++)
+        key[i] = word[i];
+    std::unordered_map<std::string, int>::iterator i = index.find(key);
+    if (i == index.end())
+        return -1;
+    return i->second;
 }
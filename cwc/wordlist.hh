@@ -23,12 +23,19 @@
 #define CWC_WORDLIST_HH
 
 #include <vector>
+#include <unordered_map>
 #include "symbol.hh"
 
 /**
  * the wordlist is a container class for the words loaded from
- * a file. Words are referenced by a integer index. The words
- * are sorted.
+ * a file. Words are referenced by a integer index. Every spelling
+ * is kept once, so the index identifies a word.
+ *
+ * A line may carry a score after the word, separated by ';' or
+ * blanks ("hello;50"); words without one score 0. load() leaves out
+ * words scoring below minscore and numbers the rest best first (in
+ * file order among equal scores), so anything indexed by word number
+ * is in score order as well.
  */
 
 class WordList
@@ -37,19 +44,38 @@ class WordList
 
 public:
     SymbolSet allalpha;
+    int minscore;
     WordList();
     void load(const std::string &fn);
-    void addWord(const std::string &word);
+    // keeps words numbered by score only if added best first
+    void addWord(const std::string &word, int score = 0);
     int numwords() {
         return widx.size();
     }
+    int score(int i) {
+        return scores[i];
+    }
+    // true if some word had a score
+    bool isscored() {
+        return scored;
+    }
+
+    // splits a line into word and score; false if the score is not a
+    // number
+    static bool parseline(const std::string &line, std::string &word, int &score);
 
     Symbol *operator[](int i) {
         return widx[i];
     }
 
+    // index of the word, or -1
+    int find(Symbol *word, int len);
+
 protected:
     std::vector<Symbol*> widx;
+    std::vector<int> scores;
+    std::unordered_map<std::string, int> index;
+    bool scored;
     bool wordok(const std::string &st);
     int nwords;
 
@@ -6,9 +6,11 @@
 #include <QPainter>
 
 #include "crossword.h"
+#include "puzzlepool.h"
 #include "drawablecell.h"
 
 #include <time.h>
+#include <stdlib.h>
 #include "cwc/symbol.hh"
 
 #ifdef REMARKABLE_DEVICE
@@ -65,11 +67,15 @@ protected:
     }
 };
 
+// for the singleton factory below, which can't capture
+static PuzzlePool *s_sudokuPool = nullptr;
+
 int main(int argc, char *argv[])
 {
     setlocale(LC_CTYPE, "");
     // Symbol::buildindex();
     qsrand(time(0));
+    srand(time(0)); // qqwing uses rand()
 
 #ifdef REMARKABLE_DEVICE
     qputenv("QMLSCENE_DEVICE", "epaper");
@@ -83,8 +89,11 @@ int main(int argc, char *argv[])
     QGuiApplication app(argc, argv);
     app.setAttribute(Qt::AA_SynthesizeMouseForUnhandledTouchEvents, false);
 
+    PuzzlePool sudokuPool("sudoku", &Crossword::generateSudoku);
+    s_sudokuPool = &sudokuPool;
+
 #ifdef REMARKABLE_DEVICE
-    {
+    if (sudokuPool.isEmpty()) {
         EPFrameBuffer::framebuffer()->fill(Qt::white);
         QPainter painter(EPFrameBuffer::framebuffer());
         painter.drawText(EPFrameBuffer::framebuffer()->rect(), Qt::AlignCenter, "Generating puzzle...");
@@ -102,7 +111,7 @@ int main(int argc, char *argv[])
     qmlRegisterType<DrawableCell>("com.iskrembilen", 1, 0, "DrawableCell");
     qmlRegisterType<TabletWindow>("com.iskrembilen", 1, 0, "TabletWindow");
     qmlRegisterSingletonType<Crossword>("com.iskrembilen", 1, 0, "Crossword", [](QQmlEngine *engine, QJSEngine*) -> QObject* {
-        Crossword *crossword = new Crossword();
+        Crossword *crossword = new Crossword(s_sudokuPool);
         engine->setObjectOwnership(crossword, QQmlEngine::JavaScriptOwnership);
         return crossword;
     });
@@ -113,5 +122,8 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // refill in the background once the UI is up
+    sudokuPool.start();
+
     return app.exec();
 }
@@ -131,7 +131,8 @@ TabletWindow {
                             // property int globalIndex: 3*parent.parent.groupIndex+index
                             property int globalIndex: Math.floor(index/3)*6 + parent.groupIndex*3 + index + Math.floor(parent.groupIndex/3)*18
 
-                            enabled: !Crossword.isFixed(globalIndex) //&& !correctText.visible
+                            property bool fixed: Crossword.puzzleRevision >= 0 && Crossword.isFixed(globalIndex)
+                            enabled: !fixed //&& !correctText.visible
 
                             Rectangle {
                                 anchors.fill: parent
@@ -143,9 +144,9 @@ TabletWindow {
                                 id: numberCell
                                 anchors.centerIn: parent
                                 // anchors.fill: parent
-                                font.bold: Crossword.isFixed(globalIndex)
-                                visible: parent.recognized === text || Crossword.isFixed(globalIndex)
-                                text: Crossword.numberAt(globalIndex)
+                                font.bold: parent.fixed
+                                visible: parent.recognized === text || parent.fixed
+                                text: Crossword.puzzleRevision >= 0 ? Crossword.numberAt(globalIndex) : ""
                                 // visible: true
                                 // text: globalIndex
                                 minimumPointSize: 10
@@ -159,6 +160,54 @@ TabletWindow {
         }
     }
 
+    Rectangle {
+        id: newGameButton
+        anchors {
+            top: parent.top
+            right: parent.right
+            margins: 20
+        }
+        width: newGameText.width + 40
+        height: newGameText.height + 20
+        border.width: 3
+        color: "transparent"
+        visible: !Crossword.generating
+
+        Text {
+            id: newGameText
+            anchors.centerIn: parent
+            font.pointSize: 20
+            text: "New game"
+        }
+
+        MouseArea {
+            anchors.fill: parent
+            onClicked: Crossword.newGame()
+        }
+    }
+
+    Rectangle {
+        anchors.fill: parent
+        visible: Crossword.generating
+        color: "white"
+
+        // jobs that report no progress jump from 0 to 1 when done
+        Text {
+            anchors.centerIn: parent
+            font.pointSize: 20
+            text: "Generating puzzle..."
+                  + (Crossword.generationProgress > 0 ? " " + Math.round(Crossword.generationProgress * 100) + "%" : "")
+                  + (Crossword.generationCancellable ? "\n(tap to cancel)" : "")
+            horizontalAlignment: Text.AlignHCenter
+        }
+
+        MouseArea {
+            anchors.fill: parent
+            enabled: Crossword.generationCancellable
+            onClicked: Crossword.cancel()
+        }
+    }
+
     // Rectangle {
     //     anchors.fill: downHints
     //     anchors.margins: -(border.width  + 2)
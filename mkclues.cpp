@@ -0,0 +1,20 @@
+// mkclues - converts a tab separated clue list (like nyt.tsv) into the
+// memory mapped clue file read by ClueStore.
+//
+// usage: mkclues <clues.tsv> <clue file>
+//
+// g++ -std=c++14 -O2 -fPIC mkclues.cpp cluestore.cpp $(pkg-config --cflags --libs Qt5Core) -o mkclues
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "cluestore.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <clues.tsv> <clue file>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return ClueStore::build(argv[1], argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+// mkjargon - extracts the glossary of jargon.xml into a clue file for
+// ClueStore, for hacker jargon themed puzzles.
+//
+// usage: mkjargon [-min n] [-max n] [-cluelength n] <jargon.xml> <clue file>
+//
+// Every glossentry with a definition becomes an answer made of the letters
+// of its glossterm. Each plain glossdef adds one clue: the first sentence of
+// its first paragraph with the sense number, grammar and usage tags
+// removed, the term itself blanked out, and cut to -cluelength characters.
+// Answers shorter than -min or longer than -max letters are dropped. The
+// file is streamed, nothing but the current entry is kept in memory.
+//
+// g++ -std=c++14 -O2 -fPIC mkjargon.cpp cluestore.cpp $(pkg-config --cflags --libs Qt5Core) -o mkjargon
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include <QFile>
+#include <QHash>
+#include <QXmlStreamReader>
+#include <QRegularExpression>
+
+#include "cluestore.h"
+
+// The DocBook DTD isn't read, so its character entities are resolved here.
+class JargonEntities : public QXmlStreamEntityResolver
+{
+public:
+    JargonEntities() {
+        const struct { const char *name; ushort unicode; } entities[] = {
+            { "lsquo", 0x2018 }, { "rsquo", 0x2019 }, { "rsqyuo", 0x2019 },
+            { "ldquo", 0x201c }, { "rdquo", 0x201d }, { "quot", '"' }, { "apos", '\'' },
+            { "mdash", 0x2014 }, { "shy", 0x00ad }, { "acute", 0x00b4 }, { "middot", 0x00b7 },
+            { "times", 0x00d7 }, { "minus", 0x2212 }, { "plusmn", 0x00b1 }, { "sim", 0x223c },
+            { "rarr", 0x2192 }, { "larr", 0x2190 }, { "hArr", 0x21d4 }, { "lang", 0x2329 },
+            { "rang", 0x232a }, { "oplus", 0x2295 }, { "otimes", 0x2297 }, { "empty", 0x2205 },
+            { "trade", 0x2122 }, { "reg", 0x00ae }, { "pound", 0x00a3 }, { "micro", 0x00b5 },
+            { "alpha", 0x03b1 }, { "iota", 0x03b9 }, { "kappa", 0x03ba }, { "lambda", 0x03bb },
+            { "Lambda", 0x039b }, { "nu", 0x03bd }, { "rho", 0x03c1 },
+            { "aacute", 0x00e1 }, { "agrave", 0x00e0 }, { "auml", 0x00e4 }, { "aelig", 0x00e6 },
+            { "eacute", 0x00e9 }, { "Eacute", 0x00c9 }, { "egrave", 0x00e8 }, { "ecirc", 0x00ea },
+            { "iuml", 0x00ef }, { "ouml", 0x00f6 }, { "Oslash", 0x00d8 }, { "uuml", 0x00fc },
+            { "szlig", 0x00df },
+        };
+        for (const auto &e : entities) {
+            m_entities.insert(QString::fromLatin1(e.name), QString(QChar(e.unicode)));
+        }
+    }
+
+    QString resolveUndeclaredEntity(const QString &name) override {
+        return m_entities.value(name);
+    }
+
+private:
+    QHash<QString, QString> m_entities;
+};
+
+// lowercase letters of the term, accents and "[tm]" stripped
+static QString answerFor(const QString &term)
+{
+    static const QRegularExpression bracketed("\\[[^\\]]*\\]");
+    QString answer;
+    for (const QChar c : QString(term).remove(bracketed).normalized(QString::NormalizationForm_KD)) {
+        QChar l = c.toLower();
+        if (l >= QLatin1Char('a') && l <= QLatin1Char('z')) {
+            answer += l;
+        }
+    }
+    return answer;
+}
+
+static QString clueFor(const QString &term, const QString &para, int maxLength)
+{
+    static const QRegularExpression tags(
+        "^(\\d+\\.|\\[[^\\]]*\\]|(n|v|vt|vi|adj|adv|pl|interj|excl|prep|pron|conj|abbrev)\\.,?|\\s)+");
+    // a sentence ends before a capital, not at "esp." or "e.g."
+    static const QRegularExpression sentence("^.*?[.!?](?=\\s+[A-Z\"\\x{2018}(]|$)");
+
+    QString clue = para.simplified();
+    clue.remove(tags);
+    QRegularExpressionMatch first = sentence.match(clue);
+    if (first.hasMatch()) {
+        clue = first.captured();
+    }
+    if (clue.endsWith(QLatin1Char('.'))) {
+        clue.chop(1);
+    }
+
+    // a clue mustn't give its answer away
+    QRegularExpression self("\\b" + QRegularExpression::escape(term) + "\\w*",
+                            QRegularExpression::CaseInsensitiveOption);
+    clue.replace(self, "~");
+
+    if (clue.size() > maxLength) {
+        int cut = clue.lastIndexOf(QLatin1Char(' '), maxLength - 3);
+        clue = clue.left(cut > 0 ? cut : maxLength - 3) + "...";
+    }
+    // plain cross references make bad clues
+    if (clue.startsWith("See ") || clue == "~") {
+        return QString();
+    }
+    return clue.trimmed();
+}
+
+static void usage(const char *name)
+{
+    std::cerr << "usage: " << name << " [-min n] [-max n] [-cluelength n] <jargon.xml> <clue file>" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    int minLength = 3, maxLength = 21, clueLength = 80;
+    std::vector<std::string> args;
+    for (int i=1; i<argc; i++) {
+        std::string a = argv[i];
+        if (a[0] != '-') {
+            args.push_back(a);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+        }
+        int v = atoi(argv[++i]);
+        if (a == "-min") minLength = v;
+        else if (a == "-max") maxLength = v;
+        else if (a == "-cluelength") clueLength = qMax(10, v);
+        else usage(argv[0]);
+    }
+    if (args.size() != 2) {
+        usage(argv[0]);
+    }
+
+    QFile file(QString::fromStdString(args[0]));
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cerr << "Failed to open " << args[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    QXmlStreamReader xml(&file);
+    JargonEntities entities;
+    xml.setEntityResolver(&entities);
+
+    std::vector<std::pair<std::string, std::string>> clues;
+    std::map<int, int> lengths;
+    int nentries = 0;
+    QString term, answer;
+    bool wantTerm = false, wantPara = false;
+    QStringList entryClues;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isEndElement() && xml.name() == QLatin1String("glossentry")) {
+            nentries++;
+            if (answer.size() < minLength || answer.size() > maxLength || entryClues.isEmpty()) {
+                continue;
+            }
+            for (const QString &clue : entryClues) {
+                clues.emplace_back(answer.toStdString(), clue.toUtf8().toStdString());
+            }
+            lengths[answer.size()]++;
+            continue;
+        }
+        if (!xml.isStartElement()) {
+            continue;
+        }
+
+        if (xml.name() == QLatin1String("glossentry")) {
+            term.clear();
+            answer.clear();
+            entryClues.clear();
+            wantTerm = true;
+            wantPara = false;
+        } else if (xml.name() == QLatin1String("glossterm") && wantTerm) {
+            term = xml.readElementText(QXmlStreamReader::IncludeChildElements).simplified();
+            answer = answerFor(term);
+            wantTerm = false;
+        } else if (xml.name() == QLatin1String("glossdef")) {
+            // etymology, history and references aren't definitions
+            wantPara = xml.attributes().value("role").isEmpty();
+        } else if (xml.name() == QLatin1String("para") && wantPara) {
+            QString clue = clueFor(term, xml.readElementText(QXmlStreamReader::IncludeChildElements), clueLength);
+            if (!clue.isEmpty()) {
+                entryClues.append(clue);
+            }
+            wantPara = false;
+        }
+    }
+    if (xml.hasError()) {
+        std::cerr << args[0] << ":" << xml.lineNumber() << ": " << xml.errorString().toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << nentries << " entries, answers by length:";
+    for (const auto &l : lengths) {
+        std::cerr << " " << l.first << ":" << l.second;
+    }
+    std::cerr << std::endl;
+    return ClueStore::write(args[1], clues) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
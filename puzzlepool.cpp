@@ -0,0 +1,204 @@
+#include "puzzlepool.h"
+
+#include <QThread>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+
+static const quint32 poolMagic = 0x706f6f6c; // "pool"
+static const quint32 poolVersion = 1;
+
+class PuzzlePoolThread : public QThread
+{
+public:
+    PuzzlePoolThread(PuzzlePool *pool) : m_pool(pool) {}
+
+protected:
+    void run() override { m_pool->refill(); }
+
+private:
+    PuzzlePool *m_pool;
+};
+
+PuzzlePool::PuzzlePool(const QString &kind, Generator generator, QObject *parent) : QObject(parent),
+    m_kind(kind),
+    m_generator(generator)
+{
+    load();
+}
+
+PuzzlePool::~PuzzlePool()
+{
+    stop();
+}
+
+int PuzzlePool::available() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_puzzles.size();
+}
+
+void PuzzlePool::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_lock);
+    m_capacity = qMax(1, capacity);
+    m_wakeup.wakeAll();
+}
+
+void PuzzlePool::setCpuBudget(qreal budget)
+{
+    QMutexLocker locker(&m_lock);
+    m_cpuBudget = qBound(0.01, budget, 1.0);
+}
+
+QByteArray PuzzlePool::take()
+{
+    QByteArray puzzle;
+    {
+        QMutexLocker locker(&m_lock);
+        if (!m_puzzles.isEmpty()) {
+            puzzle = m_puzzles.dequeue();
+            m_wakeup.wakeAll();
+        }
+    }
+
+    if (puzzle.isEmpty()) {
+        qDebug() << "Puzzle pool" << m_kind << "is empty, generating in place";
+        return m_generator();
+    }
+
+    // don't hand out the same puzzle again after a restart
+    save();
+    emit availableChanged();
+    return puzzle;
+}
+
+void PuzzlePool::start()
+{
+    if (m_thread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_lock);
+        m_stopping = false;
+    }
+    m_thread = new PuzzlePoolThread(this);
+    m_thread->start(QThread::IdlePriority);
+}
+
+void PuzzlePool::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_lock);
+        m_stopping = true;
+        m_wakeup.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    save();
+}
+
+// Runs on the pool thread. After each puzzle it sleeps long enough to keep
+// its share of the cpu at the budget, so refilling never competes with the UI.
+void PuzzlePool::refill()
+{
+    QMutexLocker locker(&m_lock);
+    while (!m_stopping) {
+        if (m_puzzles.size() >= m_capacity) {
+            m_wakeup.wait(&m_lock);
+            continue;
+        }
+
+        locker.unlock();
+        QElapsedTimer timer;
+        timer.start();
+        QByteArray puzzle = m_generator();
+        qint64 busy = timer.elapsed();
+        locker.relock();
+
+        if (puzzle.isEmpty()) {
+            qWarning() << "Puzzle pool" << m_kind << "generator failed";
+        } else {
+            m_puzzles.enqueue(puzzle);
+            bool full = m_puzzles.size() >= m_capacity;
+            locker.unlock();
+            emit availableChanged();
+            if (full) {
+                save();
+            }
+            locker.relock();
+        }
+
+        qint64 pause = qint64(busy * (1.0 - m_cpuBudget) / m_cpuBudget);
+        timer.restart();
+        while (!m_stopping && timer.elapsed() < pause) {
+            m_wakeup.wait(&m_lock, pause - timer.elapsed());
+        }
+    }
+}
+
+QString PuzzlePool::fileName() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + m_kind + ".pool";
+}
+
+void PuzzlePool::load()
+{
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != poolMagic || version != poolVersion) {
+        qWarning() << "Ignoring invalid puzzle pool" << file.fileName();
+        return;
+    }
+    QList<QByteArray> puzzles;
+    stream >> puzzles;
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Ignoring truncated puzzle pool" << file.fileName();
+        return;
+    }
+
+    QMutexLocker locker(&m_lock);
+    for (const QByteArray &puzzle : puzzles) {
+        if (!puzzle.isEmpty()) {
+            m_puzzles.enqueue(puzzle);
+        }
+    }
+    qDebug() << "Loaded" << m_puzzles.size() << "puzzles from" << file.fileName();
+}
+
+void PuzzlePool::save()
+{
+    // both threads save, keep the newest snapshot from being overwritten
+    QMutexLocker saveLocker(&m_saveLock);
+    QList<QByteArray> puzzles;
+    {
+        QMutexLocker locker(&m_lock);
+        puzzles = m_puzzles;
+    }
+
+    QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    QSaveFile file(fileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save puzzle pool to" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << poolMagic << poolVersion << puzzles;
+    if (!file.commit()) {
+        qWarning() << "Failed to save puzzle pool to" << file.fileName();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef PUZZLEPOOL_H
+#define PUZZLEPOOL_H
+
+#include <functional>
+
+#include <QObject>
+#include <QByteArray>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+// Keeps a few ready puzzles around so nobody has to wait for the generator.
+// Puzzles are opaque blobs made by the generator function, refilled on a
+// low priority thread that only uses a fraction of the cpu, and saved to
+// disk so a restart can hand one out immediately.
+class PuzzlePool : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int available READ available NOTIFY availableChanged)
+
+public:
+    typedef std::function<QByteArray()> Generator;
+
+    // kind names the file the pool is saved to
+    PuzzlePool(const QString &kind, Generator generator, QObject *parent = nullptr);
+    ~PuzzlePool();
+
+    int available() const;
+    bool isEmpty() const { return available() == 0; }
+
+    int capacity() const { return m_capacity; }
+    void setCapacity(int capacity);
+
+    // share of one core the refill thread may use, between 0 and 1
+    qreal cpuBudget() const { return m_cpuBudget; }
+    void setCpuBudget(qreal budget);
+
+    // returns a ready puzzle, or generates one right here if the pool is dry
+    QByteArray take();
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void availableChanged();
+
+private:
+    friend class PuzzlePoolThread;
+
+    void refill();
+    void load();
+    void save();
+    QString fileName() const;
+
+    QString m_kind;
+    Generator m_generator;
+
+    mutable QMutex m_lock;
+    QMutex m_saveLock;
+    QWaitCondition m_wakeup;
+    QQueue<QByteArray> m_puzzles;
+    int m_capacity = 5;
+    qreal m_cpuBudget = 0.25;
+    bool m_stopping = false;
+
+    QThread *m_thread = nullptr;
+};
+
+#endif // PUZZLEPOOL_H
@@ -18,6 +18,8 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
     main.cpp \
     crossword.cpp \
+    puzzlepool.cpp \
+    cluestore.cpp \
     drawablecell.cpp \
     characterrecognizer.cpp \
     qqwing/src/cpp/qqwing.cpp
@@ -25,7 +27,6 @@ SOURCES += \
 LIBS += -ldlib
 RESOURCES += qml.qrc \
     patterns.qrc \
-    wordlists.qrc \
     data.qrc
 
 # Additional import path used to resolve QML modules in Qt Creator's code model
@@ -41,6 +42,8 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 HEADERS += \
     crossword.h \
+    puzzlepool.h \
+    cluestore.h \
     qqwing/target/automake/config.h \
     drawablecell.h \
     characterrecognizer.h